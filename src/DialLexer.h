@@ -24,10 +24,50 @@ SOFTWARE
 #define LEXER_LIB
 
 #include <vector>
+#include <array>
+#include <cstdint>
 #include <string>
 #include <regex>
 #include <algorithm>
 #include <functional>
+#include <string_view>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <cctype>
+#include <cstring>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <exception>
+#include <chrono>
+#include <future>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DIAL_LEXER_SSE2
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define DIAL_LEXER_SSSE3
+#endif
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define DIAL_LEXER_COROUTINES
+#endif
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define DIAL_LEXER_MMAP
+#else
+#include <fstream>
+#endif
 
 
 namespace dial {
@@ -101,22 +141,30 @@ namespace dial {
 		RAW
 	};
 
-	//@Token Represent the token
+	//@DialTokenTraits Traits of a user defined token type, specialized by the user
+	//
+	//@count number of token types when they are the dense range 0 .. count - 1, 0 when unknown
+	template <typename TokenType>
+	struct DialTokenTraits {
+		static constexpr size_t count = 0;
+	};
 
-	class Token {
+	//@Token Represent the token
+	//
+	//@TokenType user defined token type, every lexer class is parameterized over it
+	template <typename TokenType>
+	class BasicToken {
 	public:
 		//@type  User defined type 
 		//@lexeme  String content representing the value
 		//@value  Semantic meaning for value
-		Token(TokenType type, string lexeme, DIAL_LEXER_VALUE value)
+		BasicToken(TokenType type, string lexeme, DIAL_LEXER_VALUE value)
+			: type(type), lexeme(std::move(lexeme)), value(value)
 		{
-			this->type = type;
-			this->lexeme = lexeme;
-			this->value = value;
 		}
 	
 		// Represent empty token
-		Token()
+		BasicToken()
 		{
 			this->line = -1;
 			this->lexeme = "";
@@ -124,42 +172,77 @@ namespace dial {
 			this->type = static_cast<TokenType>(-1);
 		}
 		//@get_type returns token type
-		TokenType get_type()
+		TokenType get_type() const
 		{
 			return this->type;
 		}
 		//@get_value returns token value
-		DIAL_LEXER_VALUE get_value()
+		DIAL_LEXER_VALUE get_value() const
 		{
 			return this->value;
 		}
 		//@get_lexeme returns token lexeme
-		string get_lexeme()
+		const string& get_lexeme() const
 		{
 			return this->lexeme;
 		}
 		//@get_line returns token line
-		int get_line()
+		int64_t get_line() const
 		{
 			return this->line;
 		}
-		void set_line(int line)
+		void set_line(int64_t line)
 		{
 			this->line = line;
 		}
+		//@get_column returns token column starting at 1, -1 when the lexer policy doesn't track columns
+		int64_t get_column() const
+		{
+			return this->column;
+		}
+		void set_column(int64_t column)
+		{
+			this->column = column;
+		}
+		//@get_offset returns the byte offset of the token in the splitted content
+		size_t get_offset() const
+		{
+			return this->offset;
+		}
+		void set_offset(size_t offset)
+		{
+			this->offset = offset;
+		}
+		//@assign reuse the token for another @type, @lexeme and @value keeping its lexeme storage
+		//
+		//@type  User defined type
+		//@lexeme  String content representing the value
+		//@value  Semantic meaning for value
+		void assign(TokenType type, std::string_view lexeme, DIAL_LEXER_VALUE value)
+		{
+			this->type = type;
+			this->lexeme.assign(lexeme.data(), lexeme.size());
+			this->value = value;
+			this->column = -1;
+		}
 		//@== token comparison
-		bool operator==(const Token& other)
+		bool operator==(const BasicToken& other) const
 		{
 			return other.lexeme == lexeme && other.type == type && other.line == line;
 		}
 
 	private:
-		int line;
+		int64_t line = -1;
+		int64_t column = -1;
+		size_t offset = 0;
 		TokenType type;
 		string  lexeme;
 		DIAL_LEXER_VALUE value;
 	};
 
+	//@Token Token of the default token type
+	using Token = BasicToken<TokenType>;
+
 	DialLexerException lex_exception = DialLexerException();
 
 	//@contains_ele utility function to check if a value exist in a container
@@ -177,6 +260,62 @@ namespace dial {
 		return false;
 	}
 
+	//@BasicTokenFilter Set of wanted token types and values used to narrow down a split
+	//
+	//@types user defined token types to keep
+	//@values semantic values to keep, an emitted string token is checked as @DIAL_STRING
+	//an empty filter keeps every token, otherwise a token is kept when its type or its value is listed
+	template <typename TokenType>
+	struct BasicTokenFilter {
+		vector<TokenType> types;
+		vector<DIAL_LEXER_VALUE> values;
+
+		//@accepts determine if a token with @type and @value passes the filter
+		//
+		//@type user defined token type
+		//@value semantic value of the emitted token
+		bool accepts(TokenType type, DIAL_LEXER_VALUE value) const {
+			if (types.empty() && values.empty()) {
+				return true;
+			}
+			return contains_ele(types, type) || contains_ele(values, value);
+		}
+	};
+
+	//@BasicSplitOptions Options used to narrow down and stop a split early
+	//
+	//@filter set of wanted token types and values
+	//@max_tokens stop once this many tokens are kept, 0 means no limit
+	//@max_bytes stop before any token starting at or after this position, 0 means no limit
+	//@stop_when stop right after the first kept token satisfying the predicate
+	template <typename TokenType>
+	struct BasicSplitOptions {
+		BasicTokenFilter<TokenType> filter;
+		size_t max_tokens = 0;
+		size_t max_bytes = 0;
+		std::function<bool(const BasicToken<TokenType>&)> stop_when;
+	};
+
+	using TokenFilter = BasicTokenFilter<TokenType>;
+	using SplitOptions = BasicSplitOptions<TokenType>;
+
+	//@SplitState Resumable position of a content splitted in slices
+	//
+	//@position position the next slice starts from
+	//@line line of the character at @position
+	//@token_count number of tokens kept so far
+	//@finished determine if the content is fully splitted or stopped by the split options
+	//@has_error determine if any slice reported a lexer error
+	//@errors lexer errors reported by all slices
+	struct SplitState {
+		size_t position = 0;
+		int64_t line = 1;
+		size_t token_count = 0;
+		bool finished = false;
+		bool has_error = false;
+		DialLexerException errors;
+	};
+
 	//@split_by_delimeter utility function to split a string object in respect to a char delimeter
 	//
 	//@txt elements to be splitted
@@ -236,18 +375,20 @@ namespace dial {
 	//
 	//@tokens a list of input tokens
 	//@key_val a key used in retrieving a token
-	[[nodiscard]] Token get_token(vector<Token>& tokens, const DIAL_LEXER_VALUE key_val) {
-		auto type_ptr = std::find_if(tokens.begin(), tokens.end(), [&](Token token) { return token.get_value() == key_val; });
-		return type_ptr != tokens.end() ? (*type_ptr) : Token();
+	template <typename TokenType>
+	[[nodiscard]] BasicToken<TokenType> get_token(const vector<BasicToken<TokenType>>& tokens, const DIAL_LEXER_VALUE key_val) {
+		auto type_ptr = std::find_if(tokens.begin(), tokens.end(), [&](const BasicToken<TokenType>& token) { return token.get_value() == key_val; });
+		return type_ptr != tokens.end() ? (*type_ptr) : BasicToken<TokenType>();
 	}
 
 	//@get_type utility function to get a TokenType using lexer value @key_val as key
 	//
 	//@tokens a list of input tokens
 	//@key_val a key used in retrieving a token
-	[[nodiscard]] TokenType get_type(vector<Token>& tokens, const DIAL_LEXER_VALUE key_val) {
-		auto token = get_token(tokens, key_val);
-		return  token == Token() ? TokenType() : token.get_type();
+	template <typename TokenType>
+	[[nodiscard]] TokenType get_type(const vector<BasicToken<TokenType>>& tokens, const DIAL_LEXER_VALUE key_val) {
+		auto type_ptr = std::find_if(tokens.begin(), tokens.end(), [&](const BasicToken<TokenType>& token) { return token.get_value() == key_val; });
+		return type_ptr != tokens.end() ? type_ptr->get_type() : TokenType();
 	}
 
 	//@verify_raw_tokens_integrity utility function to validate a list of input token for raw lexer type
@@ -257,7 +398,8 @@ namespace dial {
 	//@identifiers a list of identifier token filtered for it's lexeme
 	//@comment_start begining of comment token value
 	//@comment_end end of comment token value
-	bool verify_raw_tokens_integrity(vector<Token>& input_tokens, string& except, vector<string>& identifiers, string comment_start, string comment_end) {
+	template <typename TokenType>
+	bool verify_raw_tokens_integrity(const vector<BasicToken<TokenType>>& input_tokens, string& except, vector<string>& identifiers, const string& comment_start, const string& comment_end) {
 		string initial_content = string(except);
 		TokenType start_type = get_type(input_tokens, DIAL_LEXER_VALUE::DIAL_STRING_START);
 		TokenType end_type = get_type(input_tokens, DIAL_LEXER_VALUE::DIAL_STRING_END);
@@ -272,9 +414,9 @@ namespace dial {
 		if (!comment_start.empty() && comment_end == comment_start) {
 			except.append("cant have same token as start and end comment");
 		}
-		for (auto token : input_tokens) {
+		for (const BasicToken<TokenType>& token : input_tokens) {
 			int counter = 0;
-			for (auto token_2 : input_tokens) {
+			for (const BasicToken<TokenType>& token_2 : input_tokens) {
 				if (token.get_value() == token_2.get_value()) {
 					++counter;
 				}
@@ -283,18 +425,17 @@ namespace dial {
 				except.append("tokens must be unique except for NONE value -> " + token.get_lexeme() + "\n");
 			}
 		}
-		Token identifier_token = get_token(input_tokens, DIAL_LEXER_VALUE::DIAL_IDENTIFIER);
-		if (!(identifier_token == Token())) {
+		BasicToken<TokenType> identifier_token = get_token(input_tokens, DIAL_LEXER_VALUE::DIAL_IDENTIFIER);
+		if (!(identifier_token == BasicToken<TokenType>())) {
 			identifiers.clear();
-			string lex = identifier_token.get_lexeme();
-			size_t n_split = split_by_delimeter(lex, identifiers, '|');
+			size_t n_split = split_by_delimeter(identifier_token.get_lexeme(), identifiers, '|');
 			if (n_split < 1) {
 				except.append("token identifier must have identifiable characters or use the special constant values \n");
 			}
 			else {
-				for (string ident : identifiers) {
+				for (const string& ident : identifiers) {
 					int counter = 0;
-					for (auto ident_2 : identifiers) {
+					for (const string& ident_2 : identifiers) {
 						if (ident_2 == ident) {
 							++counter;
 						}
@@ -318,16 +459,17 @@ namespace dial {
 	//
 	//@tokens a list of input tokens
 	//@value a key used in filtering for the list of tokens
-	vector<Token> get_filtered_token(const vector<Token> tokens, DIAL_LEXER_VALUE value) {
-		vector<Token> vec;
-		std::copy_if(tokens.begin(), tokens.end(), std::back_inserter(vec), [&](Token token) {return token.get_value() == value; });
+	template <typename TokenType>
+	vector<BasicToken<TokenType>> get_filtered_token(const vector<BasicToken<TokenType>>& tokens, DIAL_LEXER_VALUE value) {
+		vector<BasicToken<TokenType>> vec;
+		std::copy_if(tokens.begin(), tokens.end(), std::back_inserter(vec), [&](const BasicToken<TokenType>& token) {return token.get_value() == value; });
 		return vec;
 	}
 
 	//@trim utility function for a trimmed representation of an input string
 	//
 	//@val input string to be trimmed
-	string trim(string val) {
+	string trim(const string& val) {
 		std::regex reg("^\\s+|\\s+$");
 		return regex_replace(val, reg, "");
 	}
@@ -336,11 +478,12 @@ namespace dial {
 	//
 	//@input_tokens a list of input tokens
 	//@except a string containing exception message
-	bool verify_regex_tokens_integrity(vector<Token>& input_tokens, string& except) {
+	template <typename TokenType>
+	bool verify_regex_tokens_integrity(const vector<BasicToken<TokenType>>& input_tokens, string& except) {
 		string initial_content = string(except);
-		for (auto token : input_tokens) {
+		for (const BasicToken<TokenType>& token : input_tokens) {
 			int counter = 0;
-			for (auto token_2 : input_tokens) {
+			for (const BasicToken<TokenType>& token_2 : input_tokens) {
 				if (token.get_lexeme() == token_2.get_lexeme()) {
 					++counter;
 				}
@@ -352,19 +495,50 @@ namespace dial {
 		return initial_content == except;
 	}
 
-	//@get_matched_token utility function to retrieve a token from a list @input_tokens based on a regex matcher @matcher
+	//@has_content utility function to check if a value holds anything but whitespaces
+	//
+	//@val value to be checked
+	bool has_content(std::string_view val) {
+		return std::any_of(val.begin(), val.end(), [](char ch) { return !std::isspace(static_cast<unsigned char>(ch)); });
+	}
+
+	//@get_matched_rule utility function to get the position of the input token matched by a regex matcher @matcher
+	//returns string::npos when only whitespaces were matched
 	//
-	//@input_tokens a list of input tokens
 	//@matcher an instance of std::regex matcher
-	Token get_matched_token(std::smatch& matcher, vector<Token>& input_tokens) {
+	size_t get_matched_rule(const std::cmatch& matcher) {
 		for (size_t i = 1; i < matcher.size(); i++) {
-			string content = trim(matcher.str(i));
-			if (!content.empty()) {
-				return input_tokens.at(i - 1);
+			if (matcher[i].matched && has_content(std::string_view(matcher[i].first, matcher[i].length()))) {
+				return i - 1;
 			}
+		}
+		return string::npos;
+	}
 
+	//@get_matched_rule utility function to get the position of the input token matched by a regex matcher @matcher
+	//when the patterns have groups of their own, only the outer group of each rule is looked at
+	//returns string::npos when only whitespaces were matched
+	//
+	//@matcher an instance of std::regex matcher
+	//@rule_groups number of the outer group of each rule
+	size_t get_matched_rule(const std::cmatch& matcher, const vector<size_t>& rule_groups) {
+		for (size_t rule = 0; rule < rule_groups.size() && rule_groups[rule] < matcher.size(); rule++) {
+			const std::csub_match& group = matcher[rule_groups[rule]];
+			if (group.matched) {
+				return has_content(std::string_view(group.first, group.length())) ? rule : string::npos;
+			}
 		}
-		return Token();
+		return string::npos;
+	}
+
+	//@get_matched_token utility function to retrieve a token from a list @input_tokens based on a regex matcher @matcher
+	//
+	//@input_tokens a list of input tokens
+	//@matcher an instance of std::regex matcher
+	template <typename TokenType>
+	BasicToken<TokenType> get_matched_token(const std::cmatch& matcher, const vector<BasicToken<TokenType>>& input_tokens) {
+		size_t rule = get_matched_rule(matcher);
+		return rule != string::npos ? input_tokens.at(rule) : BasicToken<TokenType>();
 	}
 
 	//@get_error_token utility function to get error token value
@@ -380,352 +554,4482 @@ namespace dial {
 		return error_token;
 	}
 
-	//@DialLexer Lexer class for validating and  splitting input based on predefined token rules
+	//@DialKeywordTable Perfect hash table of keywords built when a lexer is compiled
 	//
-	class DialLexer {
+	//keywords are hashed into buckets, each bucket gets a seed that sends all of its keywords to free slots,
+	//so a lookup is two hashes and a single comparison whatever the number of keywords
+	class DialKeywordTable {
 	public:
-		//@add_token method to add a token to a  list @input_tokens
+		//@build build the table from @keywords, the first of two identical lexemes is kept
 		//
-		//@token token to be added to @input_tokens 
-		void add_token(Token token)
+		//@keywords lexemes paired with the position of their input token
+		void build(const vector<std::pair<string, int>>& keywords)
 		{
-			this->input_tokens.push_back(token);
+			vector<std::pair<string, int>> unique_keywords;
+			for (const auto& keyword : keywords) {
+				auto same = [&](const std::pair<string, int>& other) { return other.first == keyword.first; };
+				if (std::none_of(unique_keywords.begin(), unique_keywords.end(), same)) {
+					unique_keywords.push_back(keyword);
+				}
+			}
+			size_t slot_count = 1;
+			while (slot_count < unique_keywords.size() * 2) {
+				slot_count <<= 1;
+			}
+			while (!try_build(unique_keywords, slot_count)) {
+				slot_count <<= 1;
+			}
 		}
 
-		//@split method to split a source content @raw based on the lexer type
+		//@find get the position of the input token of keyword @word, -1 when @word is not a keyword
 		//
-		//@raw source content to be splitted 
-		vector<Token> split(string raw)
+		//@word word to be looked up
+		int find(std::string_view word) const
 		{
-			reset_state();
-			this->source = raw;
-			vector<Token> tokens = this->type == LexerType::RAW ? raw_splitter() : regex_splitter();
-			return tokens;
+			if (rules.empty()) {
+				return -1;
+			}
+			uint32_t seed = seeds[hash(word, 0) % seeds.size()];
+			size_t slot = hash(word, seed) & (rules.size() - 1);
+			return rules[slot] >= 0 && words[slot] == word ? rules[slot] : -1;
 		}
 
-		//@Lexer-constructor takes in a lexer type defaulted at @raw
+		//@size get the number of keywords
 		//
-		//@type type of lexer to be used for splitting
-		DialLexer(LexerType type = LexerType::RAW) : type(type)
+		size_t size() const
 		{
+			return keyword_count;
 		}
 
-		//@input_token_size get the size of input token list
+	private:
+		//@hash FNV-1a hash of @word mixed with @seed
 		//
-		size_t input_token_size()
+		static uint32_t hash(std::string_view word, uint32_t seed)
 		{
-			return input_tokens.size();
+			uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+			for (unsigned char c : word) {
+				h = (h ^ c) * 16777619u;
+			}
+			return h ^ (h >> 15);
 		}
-		
-		//@set_comment set the value of @comment_begin and @comment_end
+
+		//@try_build place @keywords into @slot_count slots, false when no seed was found for a bucket
 		//
-		//@begin begining of comment token
-		//@end end of comment token
-		void set_comment(string begin, string end = "\n") {
-			this->comment_begin = begin;
-			this->comment_end = end;
+		bool try_build(const vector<std::pair<string, int>>& keywords, size_t slot_count)
+		{
+			size_t bucket_count = std::max<size_t>(keywords.size() / 2, 1);
+			vector<vector<size_t>> buckets(bucket_count);
+			for (size_t i = 0; i < keywords.size(); i++) {
+				buckets[hash(keywords[i].first, 0) % bucket_count].push_back(i);
+			}
+			vector<size_t> order(bucket_count);
+			for (size_t i = 0; i < bucket_count; i++) {
+				order[i] = i;
+			}
+			std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return buckets[a].size() > buckets[b].size(); });
+			seeds.assign(bucket_count, 0);
+			rules.assign(slot_count, -1);
+			words.assign(slot_count, string());
+			vector<size_t> placed;
+			for (size_t bucket : order) {
+				bool found = buckets[bucket].empty();
+				for (uint32_t seed = 1; !found && seed < (1u << 16); seed++) {
+					placed.clear();
+					for (size_t keyword : buckets[bucket]) {
+						size_t slot = hash(keywords[keyword].first, seed) & (slot_count - 1);
+						if (rules[slot] >= 0 || std::find(placed.begin(), placed.end(), slot) != placed.end()) {
+							break;
+						}
+						placed.push_back(slot);
+					}
+					if (placed.size() == buckets[bucket].size()) {
+						found = true;
+						seeds[bucket] = seed;
+						for (size_t i = 0; i < placed.size(); i++) {
+							rules[placed[i]] = keywords[buckets[bucket][i]].second;
+							words[placed[i]] = keywords[buckets[bucket][i]].first;
+						}
+					}
+				}
+				if (!found) {
+					return false;
+				}
+			}
+			keyword_count = keywords.size();
+			return true;
 		}
-	private:
-		LexerType type;
-		string source;
-		int current = 0, line = 1;
-		string comment_begin = "", comment_end = "";
 
-		//@advance move by one char in @source content
+		vector<uint32_t> seeds;
+		vector<int> rules;
+		vector<string> words;
+		size_t keyword_count = 0;
+	};
+
+	//@DialLiteralTrie Trie of literal lexemes answering the longest literal at a position
+	//
+	//the first byte goes through a dense table, deeper levels keep their edges sorted in one flat array
+	class DialLiteralTrie {
+	public:
+		//@build build the trie from @literals, the first of two identical lexemes is kept
 		//
-		char advance()
+		//@literals lexemes paired with the position of their input token
+		void build(const vector<std::pair<string, int>>& literals)
 		{
-			++current;
-			return current < get_eof() ? this->source[current] : -1;
+			vector<vector<std::pair<unsigned char, int>>> children(1);
+			vector<int> node_rules(1, -1);
+			for (const auto& literal : literals) {
+				int node = 0;
+				for (unsigned char c : literal.first) {
+					auto& edges = children[node];
+					auto edge = std::lower_bound(edges.begin(), edges.end(), std::make_pair(c, 0));
+					if (edge == edges.end() || edge->first != c) {
+						int child = static_cast<int>(children.size());
+						edges.insert(edge, { c, child });
+						children.emplace_back();
+						node_rules.push_back(-1);
+						node = child;
+					}
+					else {
+						node = edge->second;
+					}
+				}
+				if (node != 0 && node_rules[node] < 0) {
+					node_rules[node] = literal.second;
+				}
+			}
+			nodes.assign(children.size(), Node());
+			edge_bytes.clear();
+			edge_targets.clear();
+			for (size_t node = 0; node < children.size(); node++) {
+				nodes[node].rule = node_rules[node];
+				nodes[node].first_edge = static_cast<uint32_t>(edge_bytes.size());
+				nodes[node].edge_count = static_cast<uint32_t>(children[node].size());
+				for (const auto& edge : children[node]) {
+					edge_bytes.push_back(edge.first);
+					edge_targets.push_back(edge.second);
+				}
+			}
+			root.fill(-1);
+			for (const auto& edge : children[0]) {
+				root[edge.first] = edge.second;
+			}
 		}
 
-		//@advance operation function on @source content with line aware attribute
+		//@match get the position of the input token of the longest literal starting @text, -1 when none
 		//
-		//@func a function implementing @source operation 
-		char advance_with_line(std::function<char(void)> func)
+		//@text text to be matched from its first byte
+		//@length length of the matched literal
+		int match(std::string_view text, size_t& length) const
 		{
-			char c = func();
-			if (c == '\n') {
-				line++;
+			if (text.empty() || nodes.empty()) {
+				return -1;
+			}
+			int node = root[static_cast<unsigned char>(text[0])];
+			int rule = -1;
+			size_t position = 1;
+			while (node >= 0) {
+				if (nodes[node].rule >= 0) {
+					rule = nodes[node].rule;
+					length = position;
+				}
+				if (position == text.size()) {
+					break;
+				}
+				node = child(node, static_cast<unsigned char>(text[position++]));
 			}
-			return c;
+			return rule;
 		}
 
-		//@peek look ahead at position 1 from @source
+		//@starts determine if a literal starts with byte @c
 		//
-		char peek()
+		bool starts(unsigned char c) const
 		{
-			return peek_lookahead(1);
+			return !nodes.empty() && root[c] >= 0;
 		}
-		bool has_error = false;
 
-		//@match match the current character from @source with an expected character
+	private:
+		//@child follow the edge of @node labelled @c, -1 when there is none
 		//
-		//@expected a function implementing @source operation 
-		bool match(char expected)
+		int child(int node, unsigned char c) const
 		{
-			return current < get_eof() ? this->source[current] == expected : false;
+			const unsigned char* first = edge_bytes.data() + nodes[node].first_edge;
+			const unsigned char* last = first + nodes[node].edge_count;
+			const unsigned char* edge = std::lower_bound(first, last, c);
+			return edge != last && *edge == c ? edge_targets[edge - edge_bytes.data()] : -1;
 		}
-		//@match_comment match the current character from @source with a comment start or end token
+
+		struct Node {
+			int rule = -1;
+			uint32_t first_edge = 0;
+			uint32_t edge_count = 0;
+		};
+		std::array<int, 256> root{};
+		vector<Node> nodes;
+		vector<unsigned char> edge_bytes;
+		vector<int> edge_targets;
+	};
+
+	//@DialByteSet Set of bytes stored as a 256 bit mask
+	//
+	struct DialByteSet {
+		std::array<uint64_t, 4> words{};
+
+		//@add add byte @c to the set
 		//
-		//@handle_start a condition representing matching start or end comment
-		bool match_comment(bool handle_start) {
-			vector<char> c_container_;
-			string lex = handle_start ? this->comment_begin : this->comment_end;
-			copy(lex.begin(), lex.end(), back_inserter(c_container_));
-			int size_ = c_container_.size();
-			bool matched = false;
-			int inner_count = 0;
-			for (int i = 0; i < size_; i++) {
-				if (!is_eof() && (peek_lookahead(i) == c_container_.at(i))) {
-					inner_count++;
-				}
-				else if (is_eof() && !handle_start) {
-					has_error = true;
-					return false;
-				}
-				else {
-					return false;
-				}
+		void add(unsigned char c)
+		{
+			words[c >> 6] |= uint64_t(1) << (c & 63);
+		}
+
+		//@add_range add every byte between @first and @last included
+		//
+		void add_range(unsigned char first, unsigned char last)
+		{
+			for (int c = first; c <= last; c++) {
+				add(static_cast<unsigned char>(c));
 			}
-			matched = inner_count == size_;
-			return matched;
 		}
 
-		//@match_word match the current characters from @source with  expected characters
+		//@contains determine if byte @c is in the set
 		//
-		//@word word to be matched against
-		bool match_word(string word) {
-			vector<char> c_container_;
-			copy(word.begin(), word.end(), back_inserter(c_container_));
-			int size_ = c_container_.size();
-			int inner_count = 0;
-			for (int i = 0; i < size_; i++) {
-				if (!is_eof() && (peek_lookahead(i) == c_container_.at(i))) {
-					inner_count++;
-				}
-				else {
-					return false;
+		bool contains(unsigned char c) const
+		{
+			return (words[c >> 6] >> (c & 63)) & 1;
+		}
+
+		//@count get the number of bytes in the set
+		//
+		size_t count() const
+		{
+			size_t total = 0;
+			for (uint64_t word : words) {
+				for (; word != 0; word &= word - 1) {
+					total++;
 				}
 			}
-			return inner_count == size_;
+			return total;
 		}
 
-		//@match_identifiers match the identifiers from validated @unknown_identifiers
+		//@first get the smallest byte of the set, 256 when empty
 		//
-		//@identifier_cont container for identifier
-		//@identifier current identifier to be matched
-		//@watcher replica of @identifier
-		//@start value to determine if it is the start of matching
-		void match_identifiers(vector<string>& identifier_cont, string& identifier, string& watcher, bool start) {
-			std::for_each(identifier_cont.begin(), identifier_cont.end(), [&](string& lexeme) {
-				if (lexeme == dial::IS_IDENTIFIER_ALPHA_NUM) {
-					string content = match_get_alnum_ident();
-					if (!content.empty()) {
-						std::for_each(content.begin(), content.end(), [&](char& ele) { advance(); });
-						identifier.append(content);
-					}
-				}
-				if (lexeme == dial::IS_IDENTIFIER_ALPHA_LOWER) {
-					string content = match_get_alpha_lower_ident();
-					if (!content.empty()) {
-						std::for_each(content.begin(), content.end(), [&](char& ele) { advance(); });
-						identifier.append(content);
-					}
-				}
-				if (lexeme == dial::IS_IDENTIFIER_ALPHA_UPPER) {
-					string content = match_get_alpha_upper_ident();
-					if (!content.empty()) {
-						std::for_each(content.begin(), content.end(), [&](char& ele) { advance(); });
-						identifier.append(content);
-					}
-				}
-				if (match_word(lexeme)) {
-					std::for_each(lexeme.begin(), lexeme.end(), [&](char& ele) { advance(); });
-					identifier.append(lexeme);
+		int first() const
+		{
+			for (int c = 0; c < 256; c++) {
+				if (contains(static_cast<unsigned char>(c))) {
+					return c;
 				}
-				});
-			if (watcher != identifier) {
-				watcher = identifier;
-				match_identifiers(identifier_cont, identifier, watcher, false);
 			}
-			else if (start) {
-				match_identifiers(identifier_cont, identifier, watcher, false);
+			return 256;
+		}
+
+		//@invert keep only the bytes not in the set
+		//
+		void invert()
+		{
+			for (uint64_t& word : words) {
+				word = ~word;
 			}
 		}
 
-		//@reset_state reset @input_tokens, @current, @line state
+		//@merge add every byte of @other
 		//
-		void reset_state()
+		void merge(const DialByteSet& other)
 		{
-			output_tokens.clear();
-			current = 0;
-			line = 1;
+			for (size_t i = 0; i < words.size(); i++) {
+				words[i] |= other.words[i];
+			}
+		}
+
+		bool operator==(const DialByteSet& other) const
+		{
+			return words == other.words;
 		}
+	};
+
+	//@DialNfa Thompson automaton of a regex rule set, one match state per rule
+	//
+	//@BYTES -> consume one byte of @bytes and go to @out
+	//@SPLIT -> go to @out and @out1 without consuming
+	//@MATCH -> the input token at position @rule matched
+	struct DialNfa {
+		enum class Kind : unsigned char {
+			BYTES,
+			SPLIT,
+			MATCH
+		};
+		struct State {
+			Kind kind = Kind::SPLIT;
+			DialByteSet bytes;
+			int out = -1;
+			int out1 = -1;
+			int rule = -1;
+		};
+		vector<State> states;
+		int start = -1;
+		size_t rule_count = 0;
+	};
+
+	//@DialGlushkov Position automaton of a regex rule set with at most 64 positions
+	//
+	//@positions number of byte positions of every pattern
+	//@first positions a match can start with
+	//@last positions a match can end with
+	//@follow positions allowed after each position
+	//@bytes positions accepting each byte
+	//@rules input token position ending at each last position
+	struct DialGlushkov {
+		size_t positions = 0;
+		uint64_t first = 0;
+		uint64_t last = 0;
+		std::array<uint64_t, 64> follow{};
+		std::array<uint64_t, 256> bytes{};
+		std::array<int, 64> rules{};
+	};
+
+	//@DialRuleShape Cheapest matcher able to run a regex rule
+	//
+	//@LITERAL -> the rule only matches @literal
+	//@CLASS_RUN -> one byte of @head followed, when @repeat, by any number of bytes of @tail
+	//@COMPLEX -> the rule needs an automaton
+	struct DialRuleShape {
+		enum class Kind : unsigned char {
+			LITERAL,
+			CLASS_RUN,
+			COMPLEX
+		} kind = Kind::COMPLEX;
+		string literal;
+		DialByteSet head;
+		DialByteSet tail;
+		bool repeat = false;
+	};
 
-		//@match_get_double match double value starting from current character
+	//@DialRegexCompiler Compiler of POSIX extended patterns into a @DialNfa
+	//
+	//supports literals, escapes, `.`, bracket expressions with ranges and classes, groups, alternation and
+	//the `* + ? {m,n}` repetitions; anchors, back references and collating elements are left to std::regex
+	class DialRegexCompiler {
+	public:
+		//@compile build @nfa matching any of @patterns, false when a pattern uses unsupported syntax
 		//
-		string match_get_double() {
-			string appended_double = "", current_lex = "";
-			for (int i = 0; i < get_eof(); i++) {
-				char prob_double = peek_lookahead(i);
-				current_lex.push_back(prob_double);
-				bool is_double = validate_double(current_lex);
-				if (is_double) {
-					appended_double = current_lex;
-					continue;
-				}
-				else {
-					break;
-				}
+		//@patterns one pattern per input token, in priority order
+		//@nfa automaton to be built
+		static bool compile(const vector<string>& patterns, DialNfa& nfa)
+		{
+			vector<int> rules(patterns.size());
+			for (size_t i = 0; i < rules.size(); i++) {
+				rules[i] = static_cast<int>(i);
 			}
-			return appended_double;
+			return compile(patterns, rules, nfa);
 		}
 
-		//@match_get_alnum_ident match alphanumeric identifiers from validated @unknown_identifiers
+		//@compile build @nfa matching any of @patterns, the match of @patterns[i] reports input token @rules[i]
 		//
-		string match_get_alnum_ident() {
-			string appended_identifier = "";
-			for (int i = 0; i < get_eof(); i++) {
-				char prob_ident = peek_lookahead(i);
-				if (isalnum(prob_ident)) {
-					appended_identifier.push_back(prob_ident);
+		//@patterns patterns in priority order
+		//@rules input token position of each pattern
+		//@nfa automaton to be built
+		static bool compile(const vector<string>& patterns, const vector<int>& rules, DialNfa& nfa)
+		{
+			DialRegexCompiler compiler;
+			nfa = DialNfa();
+			nfa.rule_count = rules.empty() ? 0 : *std::max_element(rules.begin(), rules.end()) + 1;
+			vector<int> starts;
+			for (size_t i = 0; i < patterns.size(); i++) {
+				int root = compiler.parse(patterns[i]);
+				if (root < 0) {
+					return false;
 				}
-				else {
-					break;
+				int match = compiler.add_state(nfa, DialNfa::Kind::MATCH);
+				nfa.states[match].rule = rules[i];
+				int start = compiler.emit(nfa, root, match);
+				if (start < 0 || nfa.states.size() > MAX_NFA_STATES) {
+					return false;
 				}
+				starts.push_back(start);
 			}
-
-			return appended_identifier;
+			int start = compiler.add_state(nfa, DialNfa::Kind::SPLIT);
+			nfa.start = start;
+			for (size_t i = 0; i < starts.size(); i++) {
+				nfa.states[start].out = starts[i];
+				if (i + 1 < starts.size()) {
+					int next = compiler.add_state(nfa, DialNfa::Kind::SPLIT);
+					nfa.states[start].out1 = next;
+					start = next;
+				}
+			}
+			return true;
 		}
 
-		//@match_get_alpha_lower_ident match lower case alphabet identifiers from validated @unknown_identifiers
+		//@classify get the cheapest matcher of @pattern into @shape, false when the pattern uses unsupported syntax
 		//
-		string match_get_alpha_lower_ident() {
-			string appended_identifier = "";
-			for (int i = 0; i < get_eof(); i++) {
-				char prob_ident = peek_lookahead(i);
-				if (isalpha(prob_ident) && islower(prob_ident)) {
-					appended_identifier.push_back(prob_ident);
-				}
-				else {
-					break;
+		//@pattern pattern to be analyzed
+		//@shape shape of the pattern
+		static bool classify(const string& pattern, DialRuleShape& shape)
+		{
+			DialRegexCompiler compiler;
+			int root = compiler.parse(pattern);
+			if (root < 0) {
+				return false;
+			}
+			shape = DialRuleShape();
+			const vector<Node>& nodes = compiler.nodes;
+			auto is_bytes = [&](int node) { return nodes[node].kind == Node::Kind::BYTES; };
+			auto is_run = [&](int node) {
+				const Node& repeat = nodes[node];
+				return repeat.kind == Node::Kind::REPEAT && repeat.max < 0 && repeat.min <= 1 && is_bytes(repeat.children[0]);
+			};
+			const Node& top = nodes[root];
+			vector<int> parts = top.kind == Node::Kind::CONCAT ? top.children : vector<int>{ root };
+			if (std::all_of(parts.begin(), parts.end(), [&](int node) { return is_bytes(node) && nodes[node].bytes.count() == 1; })) {
+				shape.kind = DialRuleShape::Kind::LITERAL;
+				for (int node : parts) {
+					shape.literal.push_back(static_cast<char>(nodes[node].bytes.first()));
 				}
 			}
-
-			return appended_identifier;
+			else if (parts.size() == 1 && is_bytes(root)) {
+				shape.kind = DialRuleShape::Kind::CLASS_RUN;
+				shape.head = top.bytes;
+			}
+			else if (parts.size() == 1 && is_run(root)) {
+				shape.kind = DialRuleShape::Kind::CLASS_RUN;
+				shape.head = nodes[top.children[0]].bytes;
+				shape.tail = shape.head;
+				shape.repeat = true;
+			}
+			else if (parts.size() == 2 && is_bytes(parts[0]) && is_run(parts[1]) && nodes[parts[1]].min == 0) {
+				shape.kind = DialRuleShape::Kind::CLASS_RUN;
+				shape.head = nodes[parts[0]].bytes;
+				shape.tail = nodes[nodes[parts[1]].children[0]].bytes;
+				shape.repeat = true;
+			}
+			return true;
 		}
 
-		//@match_get_alpha_upper_ident match upper case alphabet identifiers from validated @unknown_identifiers
+		//@glushkov build the position automaton of @patterns into @automaton, false when a pattern uses
+		//unsupported syntax or when the patterns need more than 64 positions
 		//
-		string match_get_alpha_upper_ident() {
-			string appended_identifier = "";
-			for (int i = 0; i < get_eof(); i++) {
-				char prob_ident = peek_lookahead(i);
-				if (isalpha(prob_ident) && isupper(prob_ident)) {
-					appended_identifier.push_back(prob_ident);
+		//@patterns one pattern per input token, in priority order
+		//@automaton automaton to be built, positions of lower rules get lower bits
+		static bool glushkov(const vector<string>& patterns, DialGlushkov& automaton)
+		{
+			DialRegexCompiler compiler;
+			automaton = DialGlushkov();
+			for (size_t rule = 0; rule < patterns.size(); rule++) {
+				int root = compiler.parse(patterns[rule]);
+				if (root < 0) {
+					return false;
 				}
-				else {
-					break;
+				GlushkovInfo info;
+				if (!compiler.glushkov_node(root, automaton, info)) {
+					return false;
+				}
+				automaton.first |= info.first;
+				automaton.last |= info.last;
+				for (size_t position = 0; position < automaton.positions; position++) {
+					if ((info.last >> position) & 1) {
+						automaton.rules[position] = static_cast<int>(rule);
+					}
 				}
 			}
-
-			return appended_identifier;
+			return true;
 		}
 
-		//@get_eof get @source size
-		//
-		int const get_eof()  const
+	private:
+		static constexpr size_t MAX_NFA_STATES = 1 << 16;
+		static constexpr int MAX_REPEAT = 255;
+		static constexpr int MAX_DEPTH = 256;
+
+		struct Node {
+			enum class Kind : unsigned char {
+				BYTES,
+				CONCAT,
+				ALTERNATE,
+				REPEAT,
+				EMPTY
+			} kind = Kind::EMPTY;
+			DialByteSet bytes;
+			vector<int> children;
+			int min = 0;
+			int max = 0;
+		};
+
+		string pattern;
+		size_t position = 0;
+		vector<Node> nodes;
+
+		int add_node(Node node)
 		{
-			return this->source.size();
+			nodes.push_back(std::move(node));
+			return static_cast<int>(nodes.size() - 1);
 		}
 
-		//@is_eof determine if the current pointer is at end of file
-		//
-		bool const is_eof()
+		bool at_end() const
 		{
-			return current >= get_eof();
+			return position >= pattern.size();
 		}
 
-		//@peek_lookahead look ahead to any given point from @source
+		struct GlushkovInfo {
+			uint64_t first = 0;
+			uint64_t last = 0;
+			bool nullable = true;
+		};
+
+		//@glushkov_concat append @right to @left
 		//
-		char const peek_lookahead(int offset) const
+		static void glushkov_concat(GlushkovInfo& left, const GlushkovInfo& right, DialGlushkov& automaton)
 		{
-			int position = current + offset;
-			return position < get_eof() ? this->source[position] : -1;
+			for (size_t position = 0; position < automaton.positions; position++) {
+				if ((left.last >> position) & 1) {
+					automaton.follow[position] |= right.first;
+				}
+			}
+			left.first |= left.nullable ? right.first : 0;
+			left.last = right.last | (right.nullable ? left.last : 0);
+			left.nullable = left.nullable && right.nullable;
 		}
 
-		//@regex_splitter split @source content based on regex tokens
+		//@glushkov_node add the positions of @node to @automaton, every visit of a repeated node gets fresh positions
 		//
-		vector<Token> regex_splitter()
+		bool glushkov_node(int node, DialGlushkov& automaton, GlushkovInfo& info)
 		{
-			string exception_message = "";
-			bool status_good = verify_regex_tokens_integrity(input_tokens, exception_message);
-			if (!status_good) {
-				has_error = true;
-				throw DialLexerException(exception_message, line, current, true);
-			}
-			std::smatch matcher;
-			string patterns = "";
-			for (Token token : input_tokens) {
-				patterns.append("(").append(token.get_lexeme()).append(")|");
+			const Node& current = nodes[node];
+			info = GlushkovInfo();
+			switch (current.kind) {
+			case Node::Kind::BYTES: {
+				if (automaton.positions == 64) {
+					return false;
+				}
+				size_t position = automaton.positions++;
+				for (int c = 0; c < 256; c++) {
+					if (current.bytes.contains(static_cast<unsigned char>(c))) {
+						automaton.bytes[c] |= uint64_t(1) << position;
+					}
+				}
+				info.first = info.last = uint64_t(1) << position;
+				info.nullable = false;
+				return true;
 			}
-			string content = string(source);
-			patterns.pop_back();
-			std::regex reg(patterns, std::regex::extended);
-			while (std::regex_search(content, matcher, reg))
-			{
-				int split_pos = matcher.position();
-				current += (matcher.length() + split_pos);
-				string rem = content.substr(0, split_pos);
-
-				Token matched_token = get_matched_token(matcher, input_tokens);
-				if (matched_token == Token()) {
-					has_error = true;
-					lex_exception.add_info("can't match whitespaces", line, current, false);
+			case Node::Kind::CONCAT:
+				for (int child : current.children) {
+					GlushkovInfo child_info;
+					if (!glushkov_node(child, automaton, child_info)) {
+						return false;
+					}
+					glushkov_concat(info, child_info, automaton);
 				}
-				std::string error_token = get_error_token(rem);
-				if (!error_token.empty()) {
-					has_error = true;
-					lex_exception.add_info(rem, line, current, false);
+				return true;
+			case Node::Kind::ALTERNATE:
+				info.nullable = false;
+				for (int child : current.children) {
+					GlushkovInfo child_info;
+					if (!glushkov_node(child, automaton, child_info)) {
+						return false;
+					}
+					info.first |= child_info.first;
+					info.last |= child_info.last;
+					info.nullable = info.nullable || child_info.nullable;
 				}
-				for (auto t : rem) {
-					if (t == '\n') {
-						++line;
+				return true;
+			case Node::Kind::REPEAT: {
+				int copies = current.max < 0 ? std::max(current.min, 1) : current.max;
+				for (int copy = 0; copy < copies; copy++) {
+					GlushkovInfo child_info;
+					if (!glushkov_node(current.children[0], automaton, child_info)) {
+						return false;
 					}
+					if (current.max < 0 && copy == copies - 1) {
+						for (size_t position = 0; position < automaton.positions; position++) {
+							if ((child_info.last >> position) & 1) {
+								automaton.follow[position] |= child_info.first;
+							}
+						}
+					}
+					child_info.nullable = child_info.nullable || copy >= current.min;
+					glushkov_concat(info, child_info, automaton);
 				}
-				Token token_ = Token(matched_token.get_type(), matcher.str(), matched_token.get_value());
-				token_.set_line(line);
-				output_tokens.push_back(token_);
-				content = content.substr(split_pos + matcher.length());
+				return true;
 			}
-			std::string error_token = get_error_token(content);
-			if (!error_token.empty()) {
+			default:
+				return true;
+			}
+		}
+
+		//@parse parse the whole of @source, -1 when it uses unsupported syntax
+		//
+		int parse(const string& source)
+		{
+			pattern = source;
+			position = 0;
+			nodes.clear();
+			int root = parse_alternation(0);
+			return root >= 0 && position == pattern.size() ? root : -1;
+		}
+
+		//@parse_alternation parse branches separated by `|`
+		//
+		int parse_alternation(int depth)
+		{
+			if (depth > MAX_DEPTH) {
+				return -1;
+			}
+			Node alternate;
+			alternate.kind = Node::Kind::ALTERNATE;
+			while (true) {
+				int branch = parse_concat(depth);
+				if (branch < 0) {
+					return -1;
+				}
+				alternate.children.push_back(branch);
+				if (at_end() || pattern[position] != '|') {
+					break;
+				}
+				position++;
+			}
+			return alternate.children.size() == 1 ? alternate.children[0] : add_node(std::move(alternate));
+		}
+
+		//@parse_concat parse repeated atoms up to the end of a branch
+		//
+		int parse_concat(int depth)
+		{
+			Node concat;
+			concat.kind = Node::Kind::CONCAT;
+			while (!at_end() && pattern[position] != '|' && pattern[position] != ')') {
+				int piece = parse_repeat(depth);
+				if (piece < 0) {
+					return -1;
+				}
+				concat.children.push_back(piece);
+			}
+			if (concat.children.empty()) {
+				return add_node(Node());
+			}
+			return concat.children.size() == 1 ? concat.children[0] : add_node(std::move(concat));
+		}
+
+		//@parse_repeat parse an atom followed by its repetition operators
+		//
+		int parse_repeat(int depth)
+		{
+			int atom = parse_atom(depth);
+			while (atom >= 0 && !at_end()) {
+				char c = pattern[position];
+				int min = 0, max = 0;
+				if (c == '*' || c == '+' || c == '?') {
+					min = c == '+' ? 1 : 0;
+					max = c == '?' ? 1 : -1;
+					position++;
+				}
+				else if (c == '{') {
+					position++;
+					min = parse_count();
+					max = min;
+					if (!at_end() && pattern[position] == ',') {
+						position++;
+						max = !at_end() && pattern[position] == '}' ? -1 : parse_count();
+					}
+					if (min < 0 || (max < min && max != -1) || at_end() || pattern[position] != '}') {
+						return -1;
+					}
+					position++;
+				}
+				else {
+					break;
+				}
+				Node repeat;
+				repeat.kind = Node::Kind::REPEAT;
+				repeat.children.push_back(atom);
+				repeat.min = min;
+				repeat.max = max;
+				atom = add_node(std::move(repeat));
+			}
+			return atom;
+		}
+
+		//@parse_count parse the decimal bound of an interval, -1 when missing or too large
+		//
+		int parse_count()
+		{
+			int count = -1;
+			while (!at_end() && pattern[position] >= '0' && pattern[position] <= '9') {
+				count = std::max(count, 0) * 10 + (pattern[position++] - '0');
+				if (count > MAX_REPEAT) {
+					return -1;
+				}
+			}
+			return count;
+		}
+
+		//@parse_atom parse a group, a bracket expression, `.`, an escape or an ordinary byte
+		//
+		int parse_atom(int depth)
+		{
+			char c = pattern[position++];
+			Node bytes;
+			bytes.kind = Node::Kind::BYTES;
+			switch (c) {
+			case '(': {
+				int group = parse_alternation(depth + 1);
+				if (group < 0 || at_end() || pattern[position] != ')') {
+					return -1;
+				}
+				position++;
+				return group;
+			}
+			case '[':
+				return parse_bracket(bytes) ? add_node(std::move(bytes)) : -1;
+			case '.':
+				bytes.bytes.add_range(1, 255);
+				return add_node(std::move(bytes));
+			case '\\':
+				if (at_end()) {
+					return -1;
+				}
+				bytes.bytes.add(static_cast<unsigned char>(pattern[position++]));
+				return add_node(std::move(bytes));
+			case '^': case '$': case '*': case '+': case '?': case '{':
+				return -1;
+			default:
+				bytes.bytes.add(static_cast<unsigned char>(c));
+				return add_node(std::move(bytes));
+			}
+		}
+
+		//@parse_bracket parse a bracket expression after its `[` into @node
+		//
+		bool parse_bracket(Node& node)
+		{
+			bool negated = !at_end() && pattern[position] == '^';
+			if (negated) {
+				position++;
+			}
+			bool first = true;
+			while (!at_end() && (first || pattern[position] != ']')) {
+				first = false;
+				unsigned char c = static_cast<unsigned char>(pattern[position++]);
+				if (c == '[' && !at_end() && (pattern[position] == ':' || pattern[position] == '=' || pattern[position] == '.')) {
+					if (pattern[position] != ':') {
+						return false;
+					}
+					size_t close = pattern.find(":]", position + 1);
+					if (close == string::npos || !add_class(pattern.substr(position + 1, close - position - 1), node.bytes)) {
+						return false;
+					}
+					position = close + 2;
+					continue;
+				}
+				if (position + 1 < pattern.size() && pattern[position] == '-' && pattern[position + 1] != ']') {
+					unsigned char last = static_cast<unsigned char>(pattern[position + 1]);
+					if (last == '[' || last < c || c >= 0x80 || last >= 0x80) {
+						return false;
+					}
+					node.bytes.add_range(c, last);
+					position += 2;
+					continue;
+				}
+				node.bytes.add(c);
+			}
+			if (at_end()) {
+				return false;
+			}
+			position++;
+			if (negated) {
+				node.bytes.invert();
+			}
+			return true;
+		}
+
+		//@add_class add the bytes of the character class @name of the classic locale to @bytes
+		//
+		static bool add_class(const string& name, DialByteSet& bytes)
+		{
+			static const char* const names[] = { "alnum", "alpha", "blank", "cntrl", "digit", "graph", "lower", "print", "punct", "space", "upper", "xdigit", "w" };
+			if (std::find(std::begin(names), std::end(names), name) == std::end(names)) {
+				return false;
+			}
+			for (int c = 0; c < 128; c++) {
+				bool in_class = (name == "alnum" && std::isalnum(c)) || (name == "alpha" && std::isalpha(c)) ||
+					(name == "blank" && (c == ' ' || c == '\t')) || (name == "cntrl" && std::iscntrl(c)) ||
+					(name == "digit" && std::isdigit(c)) || (name == "graph" && std::isgraph(c)) ||
+					(name == "lower" && std::islower(c)) || (name == "print" && std::isprint(c)) ||
+					(name == "punct" && std::ispunct(c)) || (name == "space" && std::isspace(c)) ||
+					(name == "upper" && std::isupper(c)) || (name == "xdigit" && std::isxdigit(c)) ||
+					(name == "w" && (std::isalnum(c) || c == '_'));
+				if (in_class) {
+					bytes.add(static_cast<unsigned char>(c));
+				}
+			}
+			return true;
+		}
+
+		int add_state(DialNfa& nfa, DialNfa::Kind kind)
+		{
+			nfa.states.emplace_back();
+			nfa.states.back().kind = kind;
+			return static_cast<int>(nfa.states.size() - 1);
+		}
+
+		int add_split(DialNfa& nfa, int out, int out1)
+		{
+			int split = add_state(nfa, DialNfa::Kind::SPLIT);
+			nfa.states[split].out = out;
+			nfa.states[split].out1 = out1;
+			return split;
+		}
+
+		//@emit emit the states of @node in front of state @next, -1 when the automaton grows too large
+		//
+		int emit(DialNfa& nfa, int node, int next)
+		{
+			if (next < 0 || nfa.states.size() > MAX_NFA_STATES) {
+				return -1;
+			}
+			const Node& current = nodes[node];
+			switch (current.kind) {
+			case Node::Kind::BYTES: {
+				int state = add_state(nfa, DialNfa::Kind::BYTES);
+				nfa.states[state].bytes = current.bytes;
+				nfa.states[state].out = next;
+				return state;
+			}
+			case Node::Kind::CONCAT:
+				for (size_t i = current.children.size(); i-- > 0;) {
+					next = emit(nfa, current.children[i], next);
+				}
+				return next;
+			case Node::Kind::ALTERNATE: {
+				int alternative = emit(nfa, current.children.back(), next);
+				for (size_t i = current.children.size() - 1; i-- > 0 && alternative >= 0;) {
+					alternative = add_split(nfa, emit(nfa, current.children[i], next), alternative);
+				}
+				return alternative;
+			}
+			case Node::Kind::REPEAT: {
+				int child = current.children[0];
+				int tail = next;
+				if (current.max < 0) {
+					int loop = add_split(nfa, -1, next);
+					int body = emit(nfa, child, loop);
+					nfa.states[loop].out = body;
+					tail = body < 0 ? -1 : loop;
+				}
+				else {
+					for (int i = current.min; i < current.max && tail >= 0; i++) {
+						tail = add_split(nfa, emit(nfa, child, tail), next);
+					}
+				}
+				for (int i = 0; i < current.min && tail >= 0; i++) {
+					tail = emit(nfa, child, tail);
+				}
+				return tail;
+			}
+			default:
+				return next;
+			}
+		}
+	};
+
+	//@DialByteClasses Partition of the bytes into classes no pattern tells apart
+	//
+	struct DialByteClasses {
+		std::array<uint8_t, 256> classes{};
+		size_t count = 1;
+
+		//@build split the bytes by their membership in every byte set of @nfa
+		//
+		void build(const DialNfa& nfa)
+		{
+			classes.fill(0);
+			count = 1;
+			vector<const DialByteSet*> sets;
+			for (const DialNfa::State& state : nfa.states) {
+				if (state.kind == DialNfa::Kind::BYTES && std::none_of(sets.begin(), sets.end(), [&](const DialByteSet* set) { return *set == state.bytes; })) {
+					sets.push_back(&state.bytes);
+				}
+			}
+			for (const DialByteSet* set : sets) {
+				std::array<int, 512> renamed;
+				renamed.fill(-1);
+				size_t next_count = 0;
+				for (int c = 0; c < 256; c++) {
+					int signature = classes[c] * 2 + (set->contains(static_cast<unsigned char>(c)) ? 1 : 0);
+					if (renamed[signature] < 0) {
+						renamed[signature] = static_cast<int>(next_count++);
+					}
+					classes[c] = static_cast<uint8_t>(renamed[signature]);
+				}
+				count = next_count;
+			}
+		}
+
+		//@representative get one byte of class @byte_class
+		//
+		unsigned char representative(size_t byte_class) const
+		{
+			for (int c = 0; c < 256; c++) {
+				if (classes[c] == byte_class) {
+					return static_cast<unsigned char>(c);
+				}
+			}
+			return 0;
+		}
+	};
+
+	//@DialNfaSimulator Set based simulation of a @DialNfa
+	//
+	class DialNfaSimulator {
+	public:
+		//@reset simulate @nfa
+		//
+		void reset(const DialNfa* nfa)
+		{
+			this->nfa = nfa;
+			marks.assign(nfa->states.size(), 0);
+			generation = 0;
+		}
+
+		//@closure collect the sorted byte and match states reachable from @seeds without consuming input
+		//
+		void closure(const vector<int>& seeds, vector<int>& result)
+		{
+			if (++generation == 0) {
+				std::fill(marks.begin(), marks.end(), 0);
+				generation = 1;
+			}
+			result.clear();
+			stack.assign(seeds.rbegin(), seeds.rend());
+			while (!stack.empty()) {
+				int state = stack.back();
+				stack.pop_back();
+				if (state < 0 || marks[state] == generation) {
+					continue;
+				}
+				marks[state] = generation;
+				const DialNfa::State& s = nfa->states[state];
+				if (s.kind == DialNfa::Kind::SPLIT) {
+					stack.push_back(s.out1);
+					stack.push_back(s.out);
+				}
+				else {
+					result.push_back(state);
+				}
+			}
+			std::sort(result.begin(), result.end());
+		}
+
+		//@start get the states the automaton starts in
+		//
+		void start(vector<int>& result)
+		{
+			closure({ nfa->start }, result);
+		}
+
+		//@step get the states reached from @from on byte @c
+		//
+		void step(const vector<int>& from, unsigned char c, vector<int>& result)
+		{
+			seeds.clear();
+			for (int state : from) {
+				const DialNfa::State& s = nfa->states[state];
+				if (s.kind == DialNfa::Kind::BYTES && s.bytes.contains(c)) {
+					seeds.push_back(s.out);
+				}
+			}
+			closure(seeds, result);
+		}
+
+		//@accepted get the lowest rule matched by @states, -1 when none
+		//
+		int accepted(const vector<int>& states) const
+		{
+			int rule = -1;
+			for (int state : states) {
+				const DialNfa::State& s = nfa->states[state];
+				if (s.kind == DialNfa::Kind::MATCH && (rule < 0 || s.rule < rule)) {
+					rule = s.rule;
+				}
+			}
+			return rule;
+		}
+
+		//@match get the input token position of the longest non empty match starting @data, -1 when none
+		//
+		int match(const unsigned char* data, size_t size, size_t& length)
+		{
+			int rule = -1;
+			start(current_states);
+			for (size_t i = 0; !current_states.empty(); i++) {
+				int matched = i > 0 ? accepted(current_states) : -1;
+				if (matched >= 0) {
+					rule = matched;
+					length = i;
+				}
+				if (i == size) {
+					break;
+				}
+				step(current_states, data[i], next_states);
+				current_states.swap(next_states);
+			}
+			return rule;
+		}
+
+	private:
+		const DialNfa* nfa = nullptr;
+		vector<unsigned> marks;
+		vector<int> stack, seeds, current_states, next_states;
+		unsigned generation = 0;
+	};
+
+	//@DialBytePrefilter Vectorized scanner for the bytes a match can start with
+	//
+	//sets made of a few ranges are checked with SSE2 range compares, other sets with SSSE3 nibble lookups
+	//that may report a few false candidates, each candidate is confirmed by a table lookup
+	class DialBytePrefilter {
+	public:
+		//@build scan for the bytes of @first_bytes
+		//
+		void build(const DialByteSet& first_bytes)
+		{
+			table.fill(0);
+			ranges.clear();
+			for (int c = 0; c < 256; c++) {
+				if (!first_bytes.contains(static_cast<unsigned char>(c))) {
+					continue;
+				}
+				table[c] = 1;
+				if (!ranges.empty() && ranges.back().second + 1 == c) {
+					ranges.back().second = static_cast<unsigned char>(c);
+				}
+				else {
+					ranges.emplace_back(static_cast<unsigned char>(c), static_cast<unsigned char>(c));
+				}
+			}
+			//high nibbles sharing the same low nibble row share a bucket, extra rows are merged into the last one
+			vector<uint16_t> rows;
+			low_masks.fill(0);
+			high_masks.fill(0);
+			for (int high = 0; high < 16; high++) {
+				uint16_t row = 0;
+				for (int low = 0; low < 16; low++) {
+					row |= static_cast<uint16_t>(table[high * 16 + low] << low);
+				}
+				if (row == 0) {
+					continue;
+				}
+				size_t bucket = std::find(rows.begin(), rows.end(), row) - rows.begin();
+				if (bucket == rows.size()) {
+					bucket = std::min<size_t>(rows.size(), 7);
+					if (bucket == rows.size()) {
+						rows.push_back(row);
+					}
+				}
+				high_masks[high] |= static_cast<uint8_t>(1 << bucket);
+				for (int low = 0; low < 16; low++) {
+					if (row & (1 << low)) {
+						low_masks[low] |= static_cast<uint8_t>(1 << bucket);
+					}
+				}
+			}
+		}
+
+		//@find get the offset of the first byte of @data a match can start with, @size when none
+		//
+		size_t find(const unsigned char* data, size_t size) const
+		{
+			size_t i = 0;
+#if defined(DIAL_LEXER_SSE2)
+			if (ranges.size() <= MAX_SSE2_RANGES) {
+				__m128i firsts[MAX_SSE2_RANGES], widths[MAX_SSE2_RANGES];
+				for (size_t r = 0; r < ranges.size(); r++) {
+					firsts[r] = _mm_set1_epi8(static_cast<char>(ranges[r].first));
+					widths[r] = _mm_set1_epi8(static_cast<char>(ranges[r].second - ranges[r].first));
+				}
+				for (; i + 16 <= size; i += 16) {
+					__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+					__m128i hits = _mm_setzero_si128();
+					for (size_t r = 0; r < ranges.size(); r++) {
+						__m128i offset = _mm_sub_epi8(bytes, firsts[r]);
+						hits = _mm_or_si128(hits, _mm_cmpeq_epi8(_mm_min_epu8(offset, widths[r]), offset));
+					}
+					unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+					if (mask != 0) {
+						return i + lowest_bit(mask);
+					}
+				}
+			}
+#if defined(DIAL_LEXER_SSSE3)
+			else {
+				const __m128i low_lookup = _mm_loadu_si128(reinterpret_cast<const __m128i*>(low_masks.data()));
+				const __m128i high_lookup = _mm_loadu_si128(reinterpret_cast<const __m128i*>(high_masks.data()));
+				const __m128i nibble = _mm_set1_epi8(0x0f);
+				for (; i + 16 <= size; i += 16) {
+					__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+					__m128i low = _mm_shuffle_epi8(low_lookup, _mm_and_si128(bytes, nibble));
+					__m128i high = _mm_shuffle_epi8(high_lookup, _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble));
+					__m128i misses = _mm_cmpeq_epi8(_mm_and_si128(low, high), _mm_setzero_si128());
+					unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(misses)) & 0xffff;
+					for (; mask != 0; mask &= mask - 1) {
+						size_t candidate = i + lowest_bit(mask);
+						if (table[data[candidate]]) {
+							return candidate;
+						}
+					}
+				}
+			}
+#endif
+#endif
+			for (; i < size; i++) {
+				if (table[data[i]]) {
+					return i;
+				}
+			}
+			return size;
+		}
+
+		//@find_content get the offset of the first byte of @data that is not a whitespace, @size when none
+		//
+		static size_t find_content(const unsigned char* data, size_t size)
+		{
+			size_t i = 0;
+#if defined(DIAL_LEXER_SSE2)
+			const __m128i space = _mm_set1_epi8(' '), tab = _mm_set1_epi8('\t'), controls = _mm_set1_epi8('\r' - '\t');
+			for (; i + 16 <= size; i += 16) {
+				__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+				__m128i offset = _mm_sub_epi8(bytes, tab);
+				__m128i spaces = _mm_or_si128(_mm_cmpeq_epi8(bytes, space), _mm_cmpeq_epi8(_mm_min_epu8(offset, controls), offset));
+				unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(spaces)) & 0xffff;
+				if (mask != 0) {
+					return i + lowest_bit(mask);
+				}
+			}
+#endif
+			for (; i < size; i++) {
+				unsigned char c = data[i];
+				if (c != ' ' && (c < '\t' || c > '\r')) {
+					return i;
+				}
+			}
+			return size;
+		}
+
+	private:
+		static constexpr size_t MAX_SSE2_RANGES = 4;
+
+		static size_t lowest_bit(unsigned mask)
+		{
+#if defined(__GNUC__)
+			return static_cast<size_t>(__builtin_ctz(mask));
+#else
+			size_t bit = 0;
+			while (!(mask & 1)) {
+				mask >>= 1;
+				bit++;
+			}
+			return bit;
+#endif
+		}
+
+		std::array<uint8_t, 256> table{};
+		std::array<uint8_t, 16> low_masks{};
+		std::array<uint8_t, 16> high_masks{};
+		vector<std::pair<unsigned char, unsigned char>> ranges;
+	};
+
+	//@DialRegexEngine Matcher used by a regex lexer
+	//
+	//@AUTO -> the fastest engine supporting the patterns
+	//@STD_REGEX -> std::regex over the alternation of every pattern
+	//@LAZY_DFA -> automaton built on demand into a bounded cache, falling back to NFA simulation when it thrashes
+	//@DFA -> minimized automaton built when compiling, with 8 or 16 bit state tables
+	//@HYBRID -> literals in a trie, class runs in byte tables and the other rules in a DFA
+	//@SHIFT_OR -> bit parallel simulation of the position automaton, for rule sets of at most 64 positions
+	enum class DialRegexEngine {
+		AUTO,
+		STD_REGEX,
+		LAZY_DFA,
+		DFA,
+		HYBRID,
+		SHIFT_OR
+	};
+
+	//@DialRegexStats Footprint of the automaton of a regex lexer
+	//
+	//@engine engine in use after compiling
+	//@nfa_states number of states of the NFA
+	//@byte_classes number of byte classes the transitions are indexed by
+	//@dfa_states number of DFA states, cached ones for the lazy DFA and minimized ones for the DFA
+	//@unminimized_states number of DFA states before minimization
+	//@table_bytes size of the transition table
+	//@cache_bytes approximate memory used by the cached DFA states
+	//@cache_resets number of times the cache was full and flushed
+	//@nfa_matches number of matches run by NFA simulation because the cache thrashed
+	//@literal_rules number of rules the hybrid engine matches with its trie
+	//@class_rules number of rules the hybrid engine matches with byte tables
+	//@complex_rules number of rules the hybrid engine matches with its DFA
+	struct DialRegexStats {
+		DialRegexEngine engine = DialRegexEngine::STD_REGEX;
+		size_t nfa_states = 0;
+		size_t byte_classes = 0;
+		size_t dfa_states = 0;
+		size_t unminimized_states = 0;
+		size_t table_bytes = 0;
+		size_t cache_bytes = 0;
+		size_t cache_resets = 0;
+		size_t nfa_matches = 0;
+		size_t literal_rules = 0;
+		size_t class_rules = 0;
+		size_t complex_rules = 0;
+	};
+
+	//@DialLazyDfa Leftmost longest matcher building DFA states on demand
+	//
+	//states are sets of NFA states cached within a memory budget, a full cache is flushed, and when flushes
+	//happen before the cached states paid for themselves the remaining matches of the search simulate the NFA
+	class DialLazyDfa {
+	public:
+		static constexpr size_t DEFAULT_CACHE_BYTES = 1 << 20;
+
+		//@reset use @nfa with a cache of about @cache_bytes
+		//
+		void reset(std::shared_ptr<const DialNfa> nfa, size_t cache_bytes)
+		{
+			this->nfa = std::move(nfa);
+			simulator.reset(this->nfa.get());
+			byte_classes.build(*this->nfa);
+			this->cache_bytes = std::max(cache_bytes, MIN_STATES * state_cost(0));
+			cache_resets = 0;
+			nfa_matches = 0;
+			clear_cache();
+		}
+
+		//@begin_search start a new search, a previous decision to simulate the NFA is dropped
+		//
+		void begin_search()
+		{
+			thrashing = false;
+			bytes_since_reset = 0;
+		}
+
+		//@match get the input token position of the longest non empty match starting @data, -1 when none
+		//the lowest position wins between rules matching the same length
+		//
+		//@data text to be matched from its first byte
+		//@size number of bytes of @data
+		//@length length of the match
+		int match(const unsigned char* data, size_t size, size_t& length)
+		{
+			if (thrashing) {
+				nfa_matches++;
+				return simulator.match(data, size, length);
+			}
+			int rule = -1;
+			int state = start_state;
+			size_t i = 0;
+			for (; ; i++) {
+				if (i > 0 && states[state].rule >= 0) {
+					rule = states[state].rule;
+					length = i;
+				}
+				if (i == size) {
+					break;
+				}
+				size_t byte_class = byte_classes.classes[data[i]];
+				int next = transitions[static_cast<size_t>(state) * byte_classes.count + byte_class];
+				if (next == UNKNOWN) {
+					next = compute_transition(state, byte_class, data[i]);
+					if (next == FULL) {
+						nfa_matches++;
+						return simulator.match(data, size, length);
+					}
+				}
+				if (next == DEAD) {
+					break;
+				}
+				state = next;
+			}
+			bytes_since_reset += i + 1;
+			return rule;
+		}
+
+		//@fill_stats copy the cache counters into @stats
+		//
+		void fill_stats(DialRegexStats& stats) const
+		{
+			stats.byte_classes = byte_classes.count;
+			stats.dfa_states = states.size();
+			stats.table_bytes = transitions.size() * sizeof(int);
+			stats.cache_bytes = used_bytes;
+			stats.cache_resets = cache_resets;
+			stats.nfa_matches = nfa_matches;
+		}
+
+	private:
+		static constexpr int UNKNOWN = -1, DEAD = -2, FULL = -3;
+		static constexpr size_t MIN_STATES = 16;
+
+		struct State {
+			vector<int> nfa_states;
+			int rule = -1;
+		};
+
+		size_t state_cost(size_t nfa_states) const
+		{
+			return byte_classes.count * sizeof(int) + 3 * nfa_states * sizeof(int) + 96;
+		}
+
+		//@clear_cache drop every cached state and add the start state back
+		//
+		void clear_cache()
+		{
+			states.clear();
+			transitions.clear();
+			index.clear();
+			used_bytes = 0;
+			states_since_reset = 0;
+			vector<int> start_states;
+			simulator.start(start_states);
+			start_state = add_state(start_states);
+		}
+
+		//@compute_transition build the state reached from @state on byte @c of class @byte_class,
+		//FULL when the cache was flushed
+		//
+		int compute_transition(int state, size_t byte_class, unsigned char c)
+		{
+			size_t slot = static_cast<size_t>(state) * byte_classes.count + byte_class;
+			vector<int> next_states;
+			simulator.step(states[state].nfa_states, c, next_states);
+			if (next_states.empty()) {
+				transitions[slot] = DEAD;
+				return DEAD;
+			}
+			auto found = index.find(key(next_states));
+			int next = found != index.end() ? found->second : -1;
+			if (next < 0) {
+				if (used_bytes + state_cost(next_states.size()) > cache_bytes) {
+					cache_resets++;
+					thrashing = bytes_since_reset < states_since_reset * 10;
+					clear_cache();
+					bytes_since_reset = 0;
+					return FULL;
+				}
+				next = add_state(next_states);
+			}
+			transitions[slot] = next;
+			return next;
+		}
+
+		int add_state(const vector<int>& nfa_states)
+		{
+			State state;
+			state.nfa_states = nfa_states;
+			state.rule = simulator.accepted(nfa_states);
+			states.push_back(std::move(state));
+			transitions.resize(states.size() * byte_classes.count, UNKNOWN);
+			int id = static_cast<int>(states.size() - 1);
+			index.emplace(key(nfa_states), id);
+			used_bytes += state_cost(nfa_states.size());
+			states_since_reset++;
+			return id;
+		}
+
+		static string key(const vector<int>& nfa_states)
+		{
+			return string(reinterpret_cast<const char*>(nfa_states.data()), nfa_states.size() * sizeof(int));
+		}
+
+		std::shared_ptr<const DialNfa> nfa;
+		DialNfaSimulator simulator;
+		DialByteClasses byte_classes;
+		vector<State> states;
+		vector<int> transitions;
+		std::unordered_map<string, int> index;
+		int start_state = 0;
+		size_t cache_bytes = DEFAULT_CACHE_BYTES, used_bytes = 0;
+		size_t states_since_reset = 0, bytes_since_reset = 0;
+		size_t cache_resets = 0, nfa_matches = 0;
+		bool thrashing = false;
+	};
+
+	//@DialDfa Minimized leftmost longest matcher built when compiling
+	//
+	//the subset construction runs over byte classes, Hopcroft's algorithm merges equivalent states and the
+	//transitions are stored row major with 8 bit state ids, or 16 bit ones for larger automata
+	//the tables are either owned or viewed inside a lexer image, so an automaton is shared but never copied
+	class DialDfa {
+	public:
+		static constexpr size_t MAX_STATES = 1 << 12;
+
+		DialDfa() = default;
+		DialDfa(const DialDfa&) = delete;
+		DialDfa& operator=(const DialDfa&) = delete;
+
+		//@build build the automaton of @nfa, false when it needs more than @max_states states
+		//
+		//@nfa automaton to be determinized
+		//@max_states limit of states of the subset construction
+		bool build(const DialNfa& nfa, size_t max_states = MAX_STATES)
+		{
+			byte_classes.build(nfa);
+			size_t class_count = byte_classes.count;
+			vector<unsigned char> representatives(class_count);
+			for (size_t c = 0; c < class_count; c++) {
+				representatives[c] = byte_classes.representative(c);
+			}
+			DialNfaSimulator simulator;
+			simulator.reset(&nfa);
+			//state 0 is the dead state
+			vector<vector<int>> sets(1);
+			vector<int> transitions(class_count, 0), accepting(1, -1);
+			std::unordered_map<string, int> index;
+			index.emplace(string(), 0);
+			vector<int> start_states, next_states;
+			simulator.start(start_states);
+			auto add = [&](const vector<int>& nfa_states) {
+				string key(reinterpret_cast<const char*>(nfa_states.data()), nfa_states.size() * sizeof(int));
+				auto found = index.find(key);
+				if (found != index.end()) {
+					return found->second;
+				}
+				int id = static_cast<int>(sets.size());
+				index.emplace(std::move(key), id);
+				sets.push_back(nfa_states);
+				accepting.push_back(simulator.accepted(nfa_states));
+				transitions.resize(sets.size() * class_count, 0);
+				return id;
+			};
+			int start = add(start_states);
+			for (size_t state = 1; state < sets.size(); state++) {
+				if (sets.size() > max_states) {
+					return false;
+				}
+				for (size_t c = 0; c < class_count; c++) {
+					simulator.step(sets[state], representatives[c], next_states);
+					int next = add(next_states);
+					transitions[state * class_count + c] = next;
+				}
+			}
+			unminimized_states = sets.size();
+			minimize(transitions, accepting, start);
+			return true;
+		}
+
+		//@match get the input token position of the longest non empty match starting @data, -1 when none
+		//
+		int match(const unsigned char* data, size_t size, size_t& length) const
+		{
+			return narrow_table == nullptr ? run(wide_table, data, size, length) : run(narrow_table, data, size, length);
+		}
+
+		//@starts determine if a match can start with byte @c
+		//
+		bool starts(unsigned char c) const
+		{
+			size_t slot = start_state * byte_classes.count + byte_classes.classes[c];
+			return (narrow_table == nullptr ? wide_table[slot] : narrow_table[slot]) != 0;
+		}
+
+		//@fill_stats copy the table footprint into @stats
+		//
+		void fill_stats(DialRegexStats& stats) const
+		{
+			stats.byte_classes = byte_classes.count;
+			stats.dfa_states = state_count;
+			stats.unminimized_states = unminimized_states;
+			stats.table_bytes = state_count * byte_classes.count * (narrow_table == nullptr ? sizeof(uint16_t) : sizeof(uint8_t)) + sizeof(byte_classes.classes);
+		}
+
+		//@save append the tables to @image, the section starts with a @Section header
+		//
+		void save(string& image) const
+		{
+			Section section;
+			section.class_count = static_cast<uint32_t>(byte_classes.count);
+			section.state_count = static_cast<uint32_t>(state_count);
+			section.start_state = static_cast<uint32_t>(start_state);
+			section.wide = narrow_table == nullptr ? 1 : 0;
+			section.unminimized_states = static_cast<uint32_t>(unminimized_states);
+			image.append(reinterpret_cast<const char*>(&section), sizeof(section));
+			image.append(reinterpret_cast<const char*>(byte_classes.classes.data()), byte_classes.classes.size());
+			image.append(reinterpret_cast<const char*>(rules), state_count * sizeof(int32_t));
+			size_t cells = state_count * byte_classes.count;
+			if (narrow_table == nullptr) {
+				image.append(reinterpret_cast<const char*>(wide_table), cells * sizeof(uint16_t));
+			}
+			else {
+				image.append(reinterpret_cast<const char*>(narrow_table), cells);
+			}
+		}
+
+		//@attach use the tables saved at @data in place, false when they are malformed
+		//the transitions are read where they lie, @owner keeps the memory holding them alive
+		//
+		//@data section written by @save, aligned on 4 bytes
+		//@size size of the section
+		//@rule_count number of input tokens the automaton matches
+		//@owner memory holding @data
+		bool attach(const char* data, size_t size, size_t rule_count, std::shared_ptr<const void> owner)
+		{
+			Section section;
+			if (size < sizeof(section) + sizeof(byte_classes.classes) || reinterpret_cast<uintptr_t>(data) % alignof(int32_t) != 0) {
+				return false;
+			}
+			std::memcpy(&section, data, sizeof(section));
+			size_t limit = section.wide ? 1 << 16 : 1 << 8;
+			if (section.class_count == 0 || section.class_count > 256 || section.state_count == 0 || section.state_count > limit ||
+				section.start_state >= section.state_count) {
+				return false;
+			}
+			size_t cells = static_cast<size_t>(section.state_count) * section.class_count;
+			size_t rules_offset = sizeof(section) + sizeof(byte_classes.classes);
+			size_t table_offset = rules_offset + section.state_count * sizeof(int32_t);
+			if (size != table_offset + cells * (section.wide ? sizeof(uint16_t) : sizeof(uint8_t))) {
+				return false;
+			}
+			std::memcpy(byte_classes.classes.data(), data + sizeof(section), sizeof(byte_classes.classes));
+			byte_classes.count = section.class_count;
+			const int32_t* state_rules = reinterpret_cast<const int32_t*>(data + rules_offset);
+			const uint8_t* narrow = section.wide ? nullptr : reinterpret_cast<const uint8_t*>(data + table_offset);
+			const uint16_t* wide = section.wide ? reinterpret_cast<const uint16_t*>(data + table_offset) : nullptr;
+			//a corrupted image must not lead the matcher out of its tables
+			bool valid = std::all_of(byte_classes.classes.begin(), byte_classes.classes.end(), [&](uint8_t c) { return c < section.class_count; });
+			for (size_t state = 0; valid && state < section.state_count; state++) {
+				valid = state_rules[state] >= -1 && state_rules[state] < static_cast<int64_t>(rule_count);
+			}
+			for (size_t cell = 0; valid && cell < cells; cell++) {
+				valid = (wide ? wide[cell] : narrow[cell]) < section.state_count;
+			}
+			if (!valid) {
+				return false;
+			}
+			narrow_cells.clear();
+			wide_cells.clear();
+			rule_cells.clear();
+			narrow_table = narrow;
+			wide_table = wide;
+			rules = state_rules;
+			state_count = section.state_count;
+			start_state = section.start_state;
+			unminimized_states = section.unminimized_states;
+			image_owner = std::move(owner);
+			return true;
+		}
+
+	private:
+		//@Section header of the tables saved in a lexer image
+		struct Section {
+			uint32_t class_count = 0;
+			uint32_t state_count = 0;
+			uint32_t start_state = 0;
+			uint32_t wide = 0;
+			uint32_t unminimized_states = 0;
+			uint32_t reserved = 0;
+		};
+
+		template <typename StateId>
+		int run(const StateId* table, const unsigned char* data, size_t size, size_t& length) const
+		{
+			const uint8_t* classes = byte_classes.classes.data();
+			size_t class_count = byte_classes.count;
+			int rule = -1;
+			size_t state = start_state;
+			for (size_t i = 0; i < size; i++) {
+				state = table[state * class_count + classes[data[i]]];
+				if (state == 0) {
+					break;
+				}
+				if (rules[state] >= 0) {
+					rule = rules[state];
+					length = i + 1;
+				}
+			}
+			return rule;
+		}
+
+		//@minimize merge the equivalent states of @transitions with Hopcroft's algorithm and store the tables
+		//states accepting different rules are never merged, the dead state keeps id 0
+		//
+		void minimize(const vector<int>& transitions, const vector<int>& accepting, int start)
+		{
+			size_t class_count = byte_classes.count;
+			size_t subset_states = accepting.size();
+			//inverse transitions grouped by target and class
+			vector<size_t> inverse_offsets(subset_states * class_count + 1, 0);
+			for (size_t state = 0; state < subset_states; state++) {
+				for (size_t c = 0; c < class_count; c++) {
+					inverse_offsets[transitions[state * class_count + c] * class_count + c + 1]++;
+				}
+			}
+			for (size_t i = 1; i < inverse_offsets.size(); i++) {
+				inverse_offsets[i] += inverse_offsets[i - 1];
+			}
+			vector<int> inverse(subset_states * class_count);
+			vector<size_t> fill(inverse_offsets.begin(), inverse_offsets.end() - 1);
+			for (size_t state = 0; state < subset_states; state++) {
+				for (size_t c = 0; c < class_count; c++) {
+					inverse[fill[transitions[state * class_count + c] * class_count + c]++] = static_cast<int>(state);
+				}
+			}
+			//initial partition by accepted rule
+			vector<vector<int>> blocks;
+			vector<int> block_of(subset_states);
+			std::unordered_map<int, int> block_of_rule;
+			for (size_t state = 0; state < subset_states; state++) {
+				auto found = block_of_rule.find(accepting[state]);
+				if (found == block_of_rule.end()) {
+					found = block_of_rule.emplace(accepting[state], static_cast<int>(blocks.size())).first;
+					blocks.emplace_back();
+				}
+				block_of[state] = found->second;
+				blocks[found->second].push_back(static_cast<int>(state));
+			}
+			vector<int> worklist;
+			vector<bool> in_worklist(blocks.size(), true);
+			for (size_t block = 0; block < blocks.size(); block++) {
+				worklist.push_back(static_cast<int>(block));
+			}
+			vector<int> marked_count, touched, splitter;
+			vector<bool> marked(subset_states, false);
+			while (!worklist.empty()) {
+				int splitter_block = worklist.back();
+				worklist.pop_back();
+				in_worklist[splitter_block] = false;
+				splitter = blocks[splitter_block];
+				for (size_t c = 0; c < class_count; c++) {
+					touched.clear();
+					marked_count.assign(blocks.size(), 0);
+					for (int target : splitter) {
+						size_t slot = target * class_count + c;
+						for (size_t i = inverse_offsets[slot]; i < inverse_offsets[slot + 1]; i++) {
+							int source = inverse[i];
+							if (!marked[source]) {
+								marked[source] = true;
+								if (marked_count[block_of[source]]++ == 0) {
+									touched.push_back(block_of[source]);
+								}
+							}
+						}
+					}
+					for (int block : touched) {
+						if (static_cast<size_t>(marked_count[block]) < blocks[block].size()) {
+							vector<int> kept, moved;
+							for (int state : blocks[block]) {
+								(marked[state] ? kept : moved).push_back(state);
+							}
+							int new_block = static_cast<int>(blocks.size());
+							blocks[block] = std::move(kept);
+							blocks.push_back(std::move(moved));
+							for (int state : blocks[new_block]) {
+								block_of[state] = new_block;
+							}
+							if (in_worklist[block] || blocks[new_block].size() <= blocks[block].size()) {
+								worklist.push_back(new_block);
+								in_worklist.push_back(true);
+							}
+							else {
+								in_worklist.push_back(false);
+								if (!in_worklist[block]) {
+									worklist.push_back(block);
+									in_worklist[block] = true;
+								}
+							}
+						}
+					}
+					for (int block : touched) {
+						for (int state : blocks[block]) {
+							marked[state] = false;
+						}
+						if (static_cast<size_t>(block) < marked_count.size()) {
+							marked_count[block] = 0;
+						}
+					}
+					for (size_t block = marked_count.size(); block < blocks.size(); block++) {
+						for (int state : blocks[block]) {
+							marked[state] = false;
+						}
+					}
+				}
+			}
+			//renumber the blocks so the dead state is 0
+			vector<int> id_of_block(blocks.size(), -1);
+			id_of_block[block_of[0]] = 0;
+			int next_id = 1;
+			for (size_t block = 0; block < blocks.size(); block++) {
+				if (id_of_block[block] < 0) {
+					id_of_block[block] = next_id++;
+				}
+			}
+			size_t minimized = blocks.size();
+			rule_cells.assign(minimized, -1);
+			vector<int> table(minimized * class_count, 0);
+			for (size_t block = 0; block < blocks.size(); block++) {
+				int id = id_of_block[block];
+				int state = blocks[block][0];
+				rule_cells[id] = accepting[state];
+				for (size_t c = 0; c < class_count; c++) {
+					table[id * class_count + c] = id_of_block[block_of[transitions[state * class_count + c]]];
+				}
+			}
+			start_state = id_of_block[block_of[start]];
+			state_count = minimized;
+			narrow_cells.clear();
+			wide_cells.clear();
+			if (minimized <= 256) {
+				narrow_cells.assign(table.begin(), table.end());
+			}
+			else {
+				wide_cells.assign(table.begin(), table.end());
+			}
+			narrow_table = narrow_cells.empty() ? nullptr : narrow_cells.data();
+			wide_table = wide_cells.empty() ? nullptr : wide_cells.data();
+			rules = rule_cells.data();
+			image_owner.reset();
+		}
+
+		DialByteClasses byte_classes;
+		vector<uint8_t> narrow_cells;
+		vector<uint16_t> wide_cells;
+		vector<int32_t> rule_cells;
+		const uint8_t* narrow_table = nullptr;
+		const uint16_t* wide_table = nullptr;
+		const int32_t* rules = nullptr;
+		std::shared_ptr<const void> image_owner;
+		size_t state_count = 0;
+		size_t start_state = 0;
+		size_t unminimized_states = 0;
+	};
+
+	//@DialHybridMatcher Leftmost longest matcher running each rule on the cheapest matcher of its shape
+	//
+	//literal rules share a trie, class runs are scanned with byte tables and only the complex rules go
+	//through a DFA, the longest match wins and the lowest rule wins between matches of the same length
+	class DialHybridMatcher {
+	public:
+		//@build build the matchers of @patterns, false when a pattern uses unsupported syntax, when complex
+		//rules are found and @allow_complex is false, or when their DFA grows too large
+		//
+		//@patterns one pattern per input token, in priority order
+		//@allow_complex determine if complex rules may be compiled into a DFA
+		bool build(const vector<string>& patterns, bool allow_complex)
+		{
+			vector<std::pair<string, int>> literal_rules;
+			vector<string> complex_patterns;
+			vector<int> complex_rules;
+			runs.clear();
+			first_bytes.fill(0);
+			for (size_t rule = 0; rule < patterns.size(); rule++) {
+				DialRuleShape shape;
+				if (!DialRegexCompiler::classify(patterns[rule], shape)) {
+					return false;
+				}
+				if (shape.kind == DialRuleShape::Kind::LITERAL && !shape.literal.empty()) {
+					literal_rules.emplace_back(shape.literal, static_cast<int>(rule));
+					first_bytes[static_cast<unsigned char>(shape.literal[0])] = 1;
+				}
+				else if (shape.kind == DialRuleShape::Kind::CLASS_RUN) {
+					ClassRun run;
+					run.rule = static_cast<int>(rule);
+					run.repeat = shape.repeat;
+					for (int c = 0; c < 256; c++) {
+						run.head[c] = shape.head.contains(static_cast<unsigned char>(c));
+						run.tail[c] = shape.tail.contains(static_cast<unsigned char>(c));
+						first_bytes[c] |= run.head[c];
+					}
+					runs.push_back(run);
+				}
+				else if (shape.kind == DialRuleShape::Kind::COMPLEX) {
+					complex_patterns.push_back(patterns[rule]);
+					complex_rules.push_back(static_cast<int>(rule));
+				}
+			}
+			literals.build(literal_rules);
+			literal_count = literal_rules.size();
+			complex.reset();
+			if (!complex_patterns.empty()) {
+				auto nfa = std::make_shared<DialNfa>();
+				auto dfa = std::make_shared<DialDfa>();
+				if (!allow_complex || !DialRegexCompiler::compile(complex_patterns, complex_rules, *nfa) || !dfa->build(*nfa)) {
+					return false;
+				}
+				for (int c = 0; c < 256; c++) {
+					first_bytes[c] |= dfa->starts(static_cast<unsigned char>(c));
+				}
+				complex = dfa;
+			}
+			complex_count = complex_patterns.size();
+			return true;
+		}
+
+		//@match get the input token position of the longest non empty match starting @data, -1 when none
+		//
+		//@data text to be matched from its first byte
+		//@size number of bytes of @data
+		//@length length of the match
+		int match(const unsigned char* data, size_t size, size_t& length) const
+		{
+			if (size == 0 || !first_bytes[data[0]]) {
+				return -1;
+			}
+			int rule = -1;
+			size_t best = 0, candidate_length = 0;
+			auto consider = [&](int matched, size_t matched_length) {
+				if (matched >= 0 && matched_length > 0 && (matched_length > best || (matched_length == best && matched < rule))) {
+					rule = matched;
+					best = matched_length;
+				}
+			};
+			int candidate = literals.match(std::string_view(reinterpret_cast<const char*>(data), size), candidate_length);
+			consider(candidate, candidate_length);
+			for (const ClassRun& run : runs) {
+				if (!run.head[data[0]]) {
+					continue;
+				}
+				size_t run_length = 1;
+				if (run.repeat) {
+					while (run_length < size && run.tail[data[run_length]]) {
+						run_length++;
+					}
+				}
+				consider(run.rule, run_length);
+			}
+			if (complex) {
+				candidate = complex->match(data, size, candidate_length);
+				consider(candidate, candidate_length);
+			}
+			length = best;
+			return rule;
+		}
+
+		//@starts determine if a match can start with byte @c
+		//
+		bool starts(unsigned char c) const
+		{
+			return first_bytes[c] != 0;
+		}
+
+		//@fill_stats copy the rule routing and the complex DFA footprint into @stats
+		//
+		void fill_stats(DialRegexStats& stats) const
+		{
+			stats.literal_rules = literal_count;
+			stats.class_rules = runs.size();
+			stats.complex_rules = complex_count;
+			if (complex) {
+				complex->fill_stats(stats);
+			}
+		}
+
+	private:
+		struct ClassRun {
+			int rule = -1;
+			bool repeat = false;
+			std::array<uint8_t, 256> head{};
+			std::array<uint8_t, 256> tail{};
+		};
+
+		DialLiteralTrie literals;
+		vector<ClassRun> runs;
+		std::shared_ptr<const DialDfa> complex;
+		std::array<uint8_t, 256> first_bytes{};
+		size_t literal_count = 0, complex_count = 0;
+	};
+
+	//@DialShiftOrMatcher Bit parallel leftmost longest matcher over a @DialGlushkov automaton
+	//
+	//the active positions fit a single 64 bit word, one step ORs the follow sets of the active positions
+	//eight at a time through precomputed tables and masks the result with the positions of the next byte
+	class DialShiftOrMatcher {
+	public:
+		//@build build the tables of @patterns, false when they don't fit 64 positions
+		//
+		bool build(const vector<string>& patterns)
+		{
+			if (!DialRegexCompiler::glushkov(patterns, automaton)) {
+				return false;
+			}
+			chunk_count = (automaton.positions + 7) / 8;
+			follow_tables.assign(chunk_count * 256, 0);
+			for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+				for (int bits = 1; bits < 256; bits++) {
+					int lowest = 0;
+					while (!((bits >> lowest) & 1)) {
+						lowest++;
+					}
+					size_t position = chunk * 8 + lowest;
+					uint64_t follow = position < automaton.positions ? automaton.follow[position] : 0;
+					follow_tables[chunk * 256 + bits] = follow_tables[chunk * 256 + (bits & (bits - 1))] | follow;
+				}
+			}
+			return true;
+		}
+
+		//@match get the input token position of the longest non empty match starting @data, -1 when none
+		//the lowest position wins between rules matching the same length
+		//
+		//@data text to be matched from its first byte
+		//@size number of bytes of @data
+		//@length length of the match
+		int match(const unsigned char* data, size_t size, size_t& length) const
+		{
+			if (size == 0) {
+				return -1;
+			}
+			int rule = -1;
+			uint64_t active = automaton.first & automaton.bytes[data[0]];
+			for (size_t i = 1; active != 0; i++) {
+				uint64_t accepted = active & automaton.last;
+				if (accepted != 0) {
+					rule = automaton.rules[lowest_position(accepted)];
+					length = i;
+				}
+				if (i == size) {
+					break;
+				}
+				uint64_t follow = 0;
+				for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+					follow |= follow_tables[chunk * 256 + ((active >> (chunk * 8)) & 0xff)];
+				}
+				active = follow & automaton.bytes[data[i]];
+			}
+			return rule;
+		}
+
+		//@starts determine if a match can start with byte @c
+		//
+		bool starts(unsigned char c) const
+		{
+			return (automaton.first & automaton.bytes[c]) != 0;
+		}
+
+		//@fill_stats copy the automaton footprint into @stats
+		//
+		void fill_stats(DialRegexStats& stats) const
+		{
+			stats.nfa_states = automaton.positions;
+			stats.table_bytes = follow_tables.size() * sizeof(uint64_t) + sizeof(automaton.bytes);
+		}
+
+	private:
+		static size_t lowest_position(uint64_t bits)
+		{
+#if defined(__GNUC__)
+			return static_cast<size_t>(__builtin_ctzll(bits));
+#else
+			size_t position = 0;
+			while (!(bits & 1)) {
+				bits >>= 1;
+				position++;
+			}
+			return position;
+#endif
+		}
+
+		DialGlushkov automaton;
+		vector<uint64_t> follow_tables;
+		size_t chunk_count = 0;
+	};
+
+	//@DialRawEngine Rule runner used by a raw lexer
+	//
+	//@LOOP -> the rule loop reads the input tokens
+	//@BYTECODE -> a virtual machine runs the rules compiled into a @DialProgram
+	enum class DialRawEngine {
+		LOOP,
+		BYTECODE
+	};
+
+	//@DialOpcode Instruction of a raw lexer program
+	//
+	//@LITERALS -> emit the longest DIAL_NONE literal and end the rule loop, go to the next rule when none matched
+	//@LITERAL -> emit the literal of the operands and end the rule loop when it matched
+	//@STRING -> skip a string when the start lexeme of the operands matches and emit it
+	//@NUMBER -> scan and emit a number
+	//@IDENTIFIER -> scan and emit an identifier
+	//@STOP_CHECK -> end the rule loop when lexing should stop
+	//@NEXT -> go to the next rule
+	//@END_RULE -> end the rule loop when lexing should stop, otherwise go to the next rule
+	enum class DialOpcode : uint32_t {
+		LITERALS,
+		LITERAL,
+		STRING,
+		NUMBER,
+		IDENTIFIER,
+		STOP_CHECK,
+		NEXT,
+		END_RULE
+	};
+
+	//@DialProgram Bytecode of a raw lexer spec
+	//
+	//each rule is compiled into the instructions the raw lexer runs for it, @entries holds the first instruction
+	//of each rule and operands refer to lexemes stored in @pool
+	struct DialProgram {
+		static constexpr uint32_t MAGIC = 0x4c414944;
+		static constexpr uint32_t VERSION = 1;
+
+		//@Rule input token of the spec, its lexeme is at @lexeme_offset in @pool
+		struct Rule {
+			int32_t type = 0;
+			uint32_t value = 0;
+			uint32_t lexeme_offset = 0;
+			uint32_t lexeme_size = 0;
+		};
+
+		vector<uint32_t> code;
+		vector<uint32_t> entries;
+		vector<Rule> rules;
+		vector<string> identifiers;
+		string pool;
+		string comment_begin;
+		string comment_end;
+		bool keyword_mode = false;
+
+		//@add_string store @value in @pool and get its offset
+		//
+		uint32_t add_string(const string& value)
+		{
+			size_t found = pool.find(value);
+			if (found != string::npos && !value.empty()) {
+				return static_cast<uint32_t>(found);
+			}
+			pool.append(value);
+			return static_cast<uint32_t>(pool.size() - value.size());
+		}
+
+		//@lexeme get the lexeme of rule @rule
+		//
+		std::string_view lexeme(size_t rule) const
+		{
+			return std::string_view(pool).substr(rules[rule].lexeme_offset, rules[rule].lexeme_size);
+		}
+
+		//@serialize write the program into a versioned blob
+		//
+		string serialize() const
+		{
+			string blob;
+			auto put = [&](uint32_t word) { blob.append(reinterpret_cast<const char*>(&word), sizeof(word)); };
+			auto put_string = [&](const string& value) { put(static_cast<uint32_t>(value.size())); blob.append(value); };
+			put(MAGIC);
+			put(VERSION);
+			put(keyword_mode ? 1 : 0);
+			put_string(comment_begin);
+			put_string(comment_end);
+			put_string(pool);
+			put(static_cast<uint32_t>(identifiers.size()));
+			for (const string& identifier : identifiers) {
+				put_string(identifier);
+			}
+			put(static_cast<uint32_t>(rules.size()));
+			for (const Rule& rule : rules) {
+				put(static_cast<uint32_t>(rule.type));
+				put(rule.value);
+				put(rule.lexeme_offset);
+				put(rule.lexeme_size);
+				put(entries[&rule - rules.data()]);
+			}
+			put(static_cast<uint32_t>(code.size()));
+			for (uint32_t word : code) {
+				put(word);
+			}
+			return blob;
+		}
+
+		//@deserialize read a program written by @serialize, throws when @blob is not a valid program
+		//
+		//@blob serialized program
+		static DialProgram deserialize(std::string_view blob)
+		{
+			DialProgram program;
+			size_t position = 0;
+			auto fail = [&]() { return DialLexerException("invalid lexer program", 0, position, true); };
+			auto get = [&]() {
+				uint32_t word = 0;
+				if (blob.size() - position < sizeof(word)) {
+					throw fail();
+				}
+				std::memcpy(&word, blob.data() + position, sizeof(word));
+				position += sizeof(word);
+				return word;
+			};
+			auto get_string = [&]() {
+				uint32_t size = get();
+				if (blob.size() - position < size) {
+					throw fail();
+				}
+				position += size;
+				return string(blob.substr(position - size, size));
+			};
+			if (get() != MAGIC || get() != VERSION) {
+				throw fail();
+			}
+			program.keyword_mode = get() != 0;
+			program.comment_begin = get_string();
+			program.comment_end = get_string();
+			program.pool = get_string();
+			uint32_t identifier_count = get();
+			for (uint32_t i = 0; i < identifier_count; i++) {
+				program.identifiers.push_back(get_string());
+			}
+			uint32_t rule_count = get();
+			for (uint32_t i = 0; i < rule_count; i++) {
+				Rule rule;
+				rule.type = static_cast<int32_t>(get());
+				rule.value = get();
+				rule.lexeme_offset = get();
+				rule.lexeme_size = get();
+				if (rule.value > static_cast<uint32_t>(DIAL_LEXER_VALUE::DIAL_STRING) || rule.lexeme_offset > program.pool.size() ||
+					rule.lexeme_size > program.pool.size() - rule.lexeme_offset) {
+					throw fail();
+				}
+				program.rules.push_back(rule);
+				program.entries.push_back(get());
+			}
+			uint32_t code_size = get();
+			for (uint32_t i = 0; i < code_size; i++) {
+				program.code.push_back(get());
+			}
+			if (!program.verify()) {
+				throw fail();
+			}
+			return program;
+		}
+
+		//@verify determine if every entry starts an instruction and every operand stays within the program
+		//
+		bool verify() const
+		{
+			vector<bool> instructions(code.size(), false);
+			for (size_t pc = 0; pc < code.size();) {
+				instructions[pc] = true;
+				if (code[pc] > static_cast<uint32_t>(DialOpcode::END_RULE)) {
+					return false;
+				}
+				size_t operands = operand_count(static_cast<DialOpcode>(code[pc]));
+				if (pc + operands >= code.size()) {
+					return false;
+				}
+				for (size_t i = 0; i + 1 < operands; i += 2) {
+					if (code[pc + 1 + i] > pool.size() || code[pc + 2 + i] > pool.size() - code[pc + 1 + i]) {
+						return false;
+					}
+				}
+				pc += 1 + operands;
+			}
+			for (uint32_t entry : entries) {
+				if (entry >= code.size() || !instructions[entry]) {
+					return false;
+				}
+			}
+			return code.empty() || code.back() == static_cast<uint32_t>(DialOpcode::END_RULE) || code.back() == static_cast<uint32_t>(DialOpcode::NEXT);
+		}
+
+		//@operand_count get the number of operands following @opcode, lexemes take an offset and a size
+		//
+		static size_t operand_count(DialOpcode opcode)
+		{
+			switch (opcode) {
+			case DialOpcode::LITERAL:
+				return 2;
+			case DialOpcode::STRING:
+				return 4;
+			default:
+				return 0;
+			}
+		}
+	};
+
+	//@DialMappedFile Read only view of a file shared through the page cache
+	//
+	//the file is mapped on POSIX systems and read into memory elsewhere
+	class DialMappedFile {
+	public:
+		DialMappedFile(const DialMappedFile&) = delete;
+		DialMappedFile& operator=(const DialMappedFile&) = delete;
+
+		//@open map the file at @path, throws when it can't be read
+		//
+		//@path path of the file to be mapped
+		static std::shared_ptr<const DialMappedFile> open(const string& path)
+		{
+			std::shared_ptr<DialMappedFile> file(new DialMappedFile());
+#if defined(DIAL_LEXER_MMAP)
+			int descriptor = ::open(path.c_str(), O_RDONLY);
+			struct stat status;
+			bool opened = descriptor >= 0 && ::fstat(descriptor, &status) == 0;
+			if (opened && status.st_size > 0) {
+				void* mapping = ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, descriptor, 0);
+				opened = mapping != MAP_FAILED;
+				if (opened) {
+					file->mapping = static_cast<const char*>(mapping);
+					file->mapping_size = static_cast<size_t>(status.st_size);
+				}
+			}
+			if (descriptor >= 0) {
+				::close(descriptor);
+			}
+#else
+			std::ifstream stream(path, std::ios::binary);
+			bool opened = static_cast<bool>(stream);
+			if (opened) {
+				stream.seekg(0, std::ios::end);
+				std::streamoff size = stream.tellg();
+				stream.seekg(0, std::ios::beg);
+				file->buffer.resize((static_cast<size_t>(size) + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+				opened = static_cast<bool>(stream.read(reinterpret_cast<char*>(file->buffer.data()), size));
+				file->mapping = reinterpret_cast<const char*>(file->buffer.data());
+				file->mapping_size = static_cast<size_t>(size);
+			}
+#endif
+			if (!opened) {
+				throw DialLexerException("unable to read " + path, 0, 0, true);
+			}
+			return file;
+		}
+
+		~DialMappedFile()
+		{
+#if defined(DIAL_LEXER_MMAP)
+			if (mapping != nullptr) {
+				::munmap(const_cast<char*>(mapping), mapping_size);
+			}
+#endif
+		}
+
+		const char* data() const
+		{
+			return mapping;
+		}
+
+		size_t size() const
+		{
+			return mapping_size;
+		}
+
+	private:
+		DialMappedFile() = default;
+
+		const char* mapping = nullptr;
+		size_t mapping_size = 0;
+#if !defined(DIAL_LEXER_MMAP)
+		vector<uint64_t> buffer;
+#endif
+	};
+
+	//@DialImageHeader Header of a compiled lexer image
+	//
+	//sections start on 8 byte boundaries so the tables they hold are read in place
+	struct DialImageHeader {
+		static constexpr uint32_t MAGIC = 0x49584c44;
+		static constexpr uint32_t VERSION = 1;
+
+		uint32_t magic = MAGIC;
+		uint32_t version = VERSION;
+		uint32_t lexer_type = 0;
+		uint32_t regex_engine = 0;
+		uint64_t cache_bytes = 0;
+		uint32_t spec_offset = 0;
+		uint32_t spec_size = 0;
+		uint32_t dfa_offset = 0;
+		uint32_t dfa_size = 0;
+	};
+
+	//@BasicDialSpec Lexer definition read from a text spec
+	//
+	template <typename TokenType>
+	struct BasicDialSpec {
+		LexerType type = LexerType::RAW;
+		vector<BasicToken<TokenType>> tokens;
+		string comment_begin;
+		string comment_end = "\n";
+		bool keyword_mode = false;
+		DialRegexEngine regex_engine = DialRegexEngine::AUTO;
+	};
+
+	//@BasicDialSpecParser Reader of the text spec format
+	//
+	//a spec holds one directive per line, words are separated by blanks and `#` starts a comment
+	//  lexer raw|regex
+	//  comment "begin" ["end"]
+	//  keywords on|off
+	//  engine auto|std_regex|lazy_dfa|dfa|hybrid|shift_or
+	//  rule TYPE none|number|identifier|string_start|string_end [lexeme...] [priority N]
+	//lexemes are quoted strings with \n \t \" \\ escapes, identifier rules also take the classes alpha_num,
+	//alpha_lower and alpha_upper, and number rules default to the built in number scanner
+	//rules are kept in spec order unless a priority moves them, the highest priority is tried first
+	template <typename TokenType>
+	class BasicDialSpecParser {
+	public:
+		using Token = BasicToken<TokenType>;
+
+		//@parse read @text into a spec, throws one exception listing every error with its line and the position the line starts at
+		//
+		//@text content of the spec
+		//@types token type of each name used by the rules
+		//@comments determine if the comment directive is allowed, lexers whose policy has no comments reject it
+		static BasicDialSpec<TokenType> parse(std::string_view text, const std::unordered_map<string, TokenType>& types, bool comments = true)
+		{
+			BasicDialSpec<TokenType> spec;
+			std::unique_ptr<DialLexerException> errors;
+			vector<std::pair<int, Token>> rules;
+			size_t line = 0, position = 0;
+			while (!text.empty()) {
+				line++;
+				size_t end = text.find('\n');
+				std::string_view content = text.substr(0, end);
+				text = end == std::string_view::npos ? std::string_view() : text.substr(end + 1);
+				vector<Word> words;
+				string error;
+				if (split_words(content, words, error)) {
+					parse_line(words, types, comments, spec, rules, error);
+				}
+				if (!error.empty() && errors) {
+					errors->add_info("\n" + error, line, position, false);
+				}
+				else if (!error.empty()) {
+					errors = std::make_unique<DialLexerException>(error, line, position, false);
+				}
+				position += content.size() + 1;
+			}
+			if (errors) {
+				throw *errors;
+			}
+			std::stable_sort(rules.begin(), rules.end(), [](const auto& left, const auto& right) { return left.first > right.first; });
+			for (auto& rule : rules) {
+				spec.tokens.push_back(std::move(rule.second));
+			}
+			return spec;
+		}
+
+	private:
+		//@Word blank separated word of a line, quoted words are unescaped
+		struct Word {
+			string text;
+			bool quoted = false;
+		};
+
+		//@split_words cut @content into @words, false when a quoted word is malformed
+		//
+		static bool split_words(std::string_view content, vector<Word>& words, string& error)
+		{
+			size_t i = 0;
+			while (i < content.size()) {
+				char c = content[i];
+				if (c == ' ' || c == '\t' || c == '\r') {
+					i++;
+					continue;
+				}
+				if (c == '#') {
+					break;
+				}
+				Word word;
+				if (c != '"') {
+					while (i < content.size() && content[i] != ' ' && content[i] != '\t' && content[i] != '\r') {
+						word.text.push_back(content[i++]);
+					}
+					words.push_back(std::move(word));
+					continue;
+				}
+				word.quoted = true;
+				bool closed = false;
+				for (i++; i < content.size(); i++) {
+					c = content[i];
+					if (c == '"') {
+						closed = true;
+						i++;
+						break;
+					}
+					if (c == '\\' && i + 1 < content.size()) {
+						char escaped = content[++i];
+						c = escaped == 'n' ? '\n' : escaped == 't' ? '\t' : escaped;
+					}
+					word.text.push_back(c);
+				}
+				if (!closed) {
+					error = "unterminated string";
+					return false;
+				}
+				words.push_back(std::move(word));
+			}
+			return true;
+		}
+
+		//@parse_line apply the directive of @words to @spec, @error is set when it is invalid
+		//
+		static void parse_line(const vector<Word>& words, const std::unordered_map<string, TokenType>& types, bool comments,
+			BasicDialSpec<TokenType>& spec, vector<std::pair<int, Token>>& rules, string& error)
+		{
+			if (words.empty()) {
+				return;
+			}
+			const string& directive = words[0].text;
+			size_t arguments = words.size() - 1;
+			if (words[0].quoted) {
+				error = "expected a directive";
+			}
+			else if (directive == "lexer") {
+				if (arguments != 1 || (words[1].text != "raw" && words[1].text != "regex")) {
+					error = "lexer expects raw or regex";
+				}
+				else {
+					spec.type = words[1].text == "raw" ? LexerType::RAW : LexerType::REGEX;
+				}
+			}
+			else if (directive == "comment") {
+				if (!comments) {
+					error = "comments are disabled by the lexer policy";
+				}
+				else if (arguments < 1 || arguments > 2 || !words[1].quoted || (arguments == 2 && !words[2].quoted)) {
+					error = "comment expects a quoted begin and an optional quoted end";
+				}
+				else {
+					spec.comment_begin = words[1].text;
+					spec.comment_end = arguments == 2 ? words[2].text : "\n";
+				}
+			}
+			else if (directive == "keywords") {
+				if (arguments != 1 || (words[1].text != "on" && words[1].text != "off")) {
+					error = "keywords expects on or off";
+				}
+				else {
+					spec.keyword_mode = words[1].text == "on";
+				}
+			}
+			else if (directive == "engine") {
+				static const std::unordered_map<string, DialRegexEngine> engines = {
+					{ "auto", DialRegexEngine::AUTO }, { "std_regex", DialRegexEngine::STD_REGEX }, { "lazy_dfa", DialRegexEngine::LAZY_DFA },
+					{ "dfa", DialRegexEngine::DFA }, { "hybrid", DialRegexEngine::HYBRID }, { "shift_or", DialRegexEngine::SHIFT_OR }
+				};
+				auto found = arguments == 1 ? engines.find(words[1].text) : engines.end();
+				if (found == engines.end()) {
+					error = "unknown regex engine";
+				}
+				else {
+					spec.regex_engine = found->second;
+				}
+			}
+			else if (directive == "rule") {
+				parse_rule(words, types, rules, error);
+			}
+			else {
+				error = "unknown directive " + directive;
+			}
+		}
+
+		//@parse_rule read the rule of @words into @rules, @error is set when it is invalid
+		//
+		static void parse_rule(const vector<Word>& words, const std::unordered_map<string, TokenType>& types,
+			vector<std::pair<int, Token>>& rules, string& error)
+		{
+			static const std::unordered_map<string, DIAL_LEXER_VALUE> values = {
+				{ "none", DIAL_LEXER_VALUE::DIAL_NONE }, { "number", DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE },
+				{ "identifier", DIAL_LEXER_VALUE::DIAL_IDENTIFIER }, { "string_start", DIAL_LEXER_VALUE::DIAL_STRING_START },
+				{ "string_end", DIAL_LEXER_VALUE::DIAL_STRING_END }
+			};
+			static const std::unordered_map<string, string> classes = {
+				{ "alpha_num", IS_IDENTIFIER_ALPHA_NUM }, { "alpha_lower", IS_IDENTIFIER_ALPHA_LOWER }, { "alpha_upper", IS_IDENTIFIER_ALPHA_UPPER }
+			};
+			if (words.size() < 3) {
+				error = "rule expects a type and a value";
+				return;
+			}
+			auto type = types.find(words[1].text);
+			if (type == types.end()) {
+				error = "unknown token type " + words[1].text;
+				return;
+			}
+			auto value = values.find(words[2].text);
+			if (value == values.end()) {
+				error = "unknown token value " + words[2].text;
+				return;
+			}
+			size_t last = words.size();
+			int priority = 0;
+			if (last >= 5 && !words[last - 2].quoted && words[last - 2].text == "priority") {
+				const string& number = words[last - 1].text;
+				bool digits = !number.empty() && std::all_of(number.begin() + (number[0] == '-' ? 1 : 0), number.end(), [](char c) { return c >= '0' && c <= '9'; });
+				if (!digits || number.size() > 9) {
+					error = "priority expects an integer";
+					return;
+				}
+				priority = std::stoi(number);
+				last -= 2;
+			}
+			string lexeme;
+			for (size_t i = 3; i < last; i++) {
+				string part = words[i].text;
+				if (!words[i].quoted) {
+					auto found = classes.find(part);
+					if (value->second != DIAL_LEXER_VALUE::DIAL_IDENTIFIER || found == classes.end()) {
+						error = "unexpected word " + part;
+						return;
+					}
+					part = found->second;
+				}
+				lexeme.append(lexeme.empty() ? "" : "|").append(part);
+			}
+			if (lexeme.empty() && value->second == DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE) {
+				lexeme = IS_NUMBER;
+			}
+			else if (lexeme.empty()) {
+				error = "rule expects a lexeme";
+				return;
+			}
+			else if (last - 3 > 1 && value->second != DIAL_LEXER_VALUE::DIAL_IDENTIFIER) {
+				error = "rule expects a single lexeme";
+				return;
+			}
+			rules.emplace_back(priority, Token(type->second, lexeme, value->second));
+		}
+	};
+
+	//@BasicDialBatchResult Result of one document splitted by a batch
+	//
+	//@tokens tokens splitted before the document finished or failed
+	//@has_error determine if the document failed
+	//@error lexer error message of the failed document
+	template <typename TokenType>
+	struct BasicDialBatchResult {
+		vector<BasicToken<TokenType>> tokens;
+		bool has_error = false;
+		string error;
+	};
+
+	using DialSpec = BasicDialSpec<TokenType>;
+	using DialSpecParser = BasicDialSpecParser<TokenType>;
+	using DialBatchResult = BasicDialBatchResult<TokenType>;
+
+	//@DialThreadPool Work stealing thread pool running indexed tasks
+	//
+	//each worker owns a queue seeded with a contiguous block of tasks, it takes its own tasks from the front
+	//and steals from the back of the other queues once its own queue is empty
+	class DialThreadPool {
+	public:
+		using TaskFunction = std::function<void(size_t task, size_t worker)>;
+
+		//@DialThreadPool-constructor start @worker_count threads, at least one
+		//
+		//@worker_count number of worker threads
+		explicit DialThreadPool(size_t worker_count = std::thread::hardware_concurrency())
+		{
+			worker_count = std::max<size_t>(worker_count, 1);
+			for (size_t i = 0; i < worker_count; i++) {
+				queues.push_back(std::make_unique<WorkQueue>());
+			}
+			for (size_t i = 0; i < worker_count; i++) {
+				threads.emplace_back([this, i]() { work(i); });
+			}
+		}
+
+		DialThreadPool(const DialThreadPool&) = delete;
+		DialThreadPool& operator=(const DialThreadPool&) = delete;
+
+		~DialThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(state_mutex);
+				stopping = true;
+			}
+			wake.notify_all();
+			for (std::thread& thread : threads) {
+				thread.join();
+			}
+		}
+
+		//@shared pool sized to the hardware used by default for batches
+		//
+		static DialThreadPool& shared()
+		{
+			static DialThreadPool pool;
+			return pool;
+		}
+
+		//@size get the number of workers
+		//
+		size_t size() const
+		{
+			return threads.size();
+		}
+
+		//@run call @task for every task index in [0, @task_count) and wait for all of them
+		//the first exception thrown by a task is rethrown once every task finished
+		//
+		//@task_count number of tasks
+		//@task function called with the task index and the index of the worker running it
+		void run(size_t task_count, const TaskFunction& task)
+		{
+			if (task_count == 0) {
+				return;
+			}
+			std::lock_guard<std::mutex> run_lock(run_mutex);
+			job = &task;
+			failure = nullptr;
+			remaining = task_count;
+			size_t worker_count = queues.size();
+			for (size_t i = 0; i < worker_count; i++) {
+				std::lock_guard<std::mutex> lock(queues[i]->mutex);
+				for (size_t t = task_count * i / worker_count; t < task_count * (i + 1) / worker_count; t++) {
+					queues[i]->tasks.push_back(t);
+				}
+			}
+			std::unique_lock<std::mutex> lock(state_mutex);
+			++generation;
+			wake.notify_all();
+			done.wait(lock, [this]() { return remaining == 0; });
+			if (failure) {
+				std::rethrow_exception(failure);
+			}
+		}
+
+	private:
+		struct WorkQueue {
+			std::mutex mutex;
+			std::deque<size_t> tasks;
+		};
+
+		//@pop_task take a task from the worker's own queue or steal one from another worker
+		//
+		//@worker index of the worker
+		//@task index of the task taken
+		bool pop_task(size_t worker, size_t& task)
+		{
+			{
+				WorkQueue& own = *queues[worker];
+				std::lock_guard<std::mutex> lock(own.mutex);
+				if (!own.tasks.empty()) {
+					task = own.tasks.front();
+					own.tasks.pop_front();
+					return true;
+				}
+			}
+			for (size_t i = 1; i < queues.size(); i++) {
+				WorkQueue& victim = *queues[(worker + i) % queues.size()];
+				std::lock_guard<std::mutex> lock(victim.mutex);
+				if (!victim.tasks.empty()) {
+					task = victim.tasks.back();
+					victim.tasks.pop_back();
+					return true;
+				}
+			}
+			return false;
+		}
+
+		//@work worker loop waiting for a run and draining the queues
+		//
+		//@worker index of the worker
+		void work(size_t worker)
+		{
+			size_t seen_generation = 0;
+			while (true) {
+				{
+					std::unique_lock<std::mutex> lock(state_mutex);
+					wake.wait(lock, [&]() { return stopping || generation != seen_generation; });
+					if (stopping) {
+						return;
+					}
+					seen_generation = generation;
+				}
+				size_t task = 0;
+				while (pop_task(worker, task)) {
+					try {
+						(*job)(task, worker);
+					}
+					catch (...) {
+						std::lock_guard<std::mutex> lock(state_mutex);
+						if (!failure) {
+							failure = std::current_exception();
+						}
+					}
+					if (remaining.fetch_sub(1) == 1) {
+						std::lock_guard<std::mutex> lock(state_mutex);
+						done.notify_all();
+					}
+				}
+			}
+		}
+
+		vector<std::thread> threads;
+		vector<std::unique_ptr<WorkQueue>> queues;
+		std::mutex run_mutex, state_mutex;
+		std::condition_variable wake, done;
+		const TaskFunction* job = nullptr;
+		std::exception_ptr failure;
+		std::atomic<size_t> remaining{ 0 };
+		size_t generation = 0;
+		bool stopping = false;
+	};
+
+	//@DialLineIndex Line and column lookup of byte offsets in a source content
+	//the newline offsets are found with memchr on the first lookup, then each lookup is a binary search
+	//so tokens splitted without positions can still be located on demand
+	//
+	//lookups build the index lazily, an index shared by threads must be built first with @build
+	class DialLineIndex {
+	public:
+		//@DialLineIndex-constructor index @source, which must outlive the index
+		//
+		//@source content the offsets are looked up in
+		explicit DialLineIndex(std::string_view source) : source(source)
+		{
+		}
+
+		//@build find the newline offsets of @source if not already done
+		//
+		void build() const
+		{
+			if (built) {
+				return;
+			}
+			const char* data = source.data();
+			const char* end = data + source.size();
+			for (const char* it = data; it < end && (it = static_cast<const char*>(std::memchr(it, '\n', end - it))) != nullptr; ++it) {
+				newlines.push_back(it - data);
+			}
+			built = true;
+		}
+
+		//@line_of get the line of @offset starting at 1, a newline belongs to the line it ends
+		//
+		//@offset byte offset in @source
+		size_t line_of(size_t offset) const
+		{
+			build();
+			return std::lower_bound(newlines.begin(), newlines.end(), offset) - newlines.begin() + 1;
+		}
+
+		//@column_of get the column of @offset starting at 1
+		//
+		//@offset byte offset in @source
+		size_t column_of(size_t offset) const
+		{
+			size_t line = line_of(offset);
+			return line > 1 ? offset - newlines[line - 2] : offset + 1;
+		}
+
+		//@line_count get the number of lines of @source
+		//
+		size_t line_count() const
+		{
+			build();
+			return newlines.size() + 1;
+		}
+
+	private:
+		std::string_view source;
+		mutable vector<size_t> newlines;
+		mutable bool built = false;
+	};
+
+#if defined(DIAL_LEXER_COROUTINES)
+	//@BasicDialTokenStream Tokens of a content lexed by a coroutine while it is being read, see @BasicDialLexer::split_async
+	//
+	//each awaited @next resumes the lexing until the tokens of the next read buffer are ready, the lexing is
+	//suspended while its reader waits so one thread can keep many contents in flight
+	//
+	//@TokenType user defined token type of the tokens
+	template <typename TokenType>
+	class BasicDialTokenStream {
+	public:
+		using Token = BasicToken<TokenType>;
+
+		struct promise_type;
+		using Handle = std::coroutine_handle<promise_type>;
+
+		//@FinalAwaiter hand control back to the awaiting consumer once lexing is done
+		struct FinalAwaiter {
+			bool await_ready() const noexcept { return false; }
+			std::coroutine_handle<> await_suspend(Handle handle) noexcept
+			{
+				std::coroutine_handle<> consumer = handle.promise().consumer;
+				return consumer ? consumer : std::noop_coroutine();
+			}
+			void await_resume() const noexcept {}
+		};
+
+		struct promise_type {
+			const vector<Token>* tokens = nullptr;
+			std::coroutine_handle<> consumer;
+			std::exception_ptr failure;
+
+			BasicDialTokenStream get_return_object() { return BasicDialTokenStream(Handle::from_promise(*this)); }
+			std::suspend_always initial_suspend() const noexcept { return {}; }
+			FinalAwaiter final_suspend() const noexcept { return {}; }
+			FinalAwaiter yield_value(const vector<Token>& ready) noexcept
+			{
+				tokens = &ready;
+				return {};
+			}
+			void return_void() const noexcept {}
+			void unhandled_exception() { failure = std::current_exception(); }
+		};
+
+		//@NextAwaiter resume the lexing from the awaiting consumer
+		struct NextAwaiter {
+			Handle handle;
+
+			bool await_ready() const noexcept { return !handle || handle.done(); }
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) noexcept
+			{
+				handle.promise().consumer = consumer;
+				handle.promise().tokens = nullptr;
+				return handle;
+			}
+			bool await_resume() const
+			{
+				if (!handle) {
+					return false;
+				}
+				if (handle.promise().failure) {
+					std::exception_ptr failure = std::exchange(handle.promise().failure, nullptr);
+					std::rethrow_exception(failure);
+				}
+				return !handle.done();
+			}
+		};
+
+		BasicDialTokenStream(BasicDialTokenStream&& other) noexcept : handle(std::exchange(other.handle, nullptr))
+		{
+		}
+
+		BasicDialTokenStream& operator=(BasicDialTokenStream&& other) noexcept
+		{
+			if (this != &other) {
+				destroy();
+				handle = std::exchange(other.handle, nullptr);
+			}
+			return *this;
+		}
+
+		BasicDialTokenStream(const BasicDialTokenStream&) = delete;
+		BasicDialTokenStream& operator=(const BasicDialTokenStream&) = delete;
+
+		~BasicDialTokenStream()
+		{
+			destroy();
+		}
+
+		//@next await the tokens of the next buffer, gives false once the content is lexed
+		//lexer errors are thrown from here
+		//
+		NextAwaiter next()
+		{
+			return NextAwaiter{ handle };
+		}
+
+		//@tokens get the tokens handed out by the last awaited @next, valid until the next one
+		//
+		const vector<Token>& tokens() const
+		{
+			return *handle.promise().tokens;
+		}
+
+	private:
+		explicit BasicDialTokenStream(Handle handle) : handle(handle)
+		{
+		}
+
+		void destroy()
+		{
+			if (handle) {
+				handle.destroy();
+				handle = nullptr;
+			}
+		}
+
+		Handle handle;
+	};
+#endif
+
+	//@DialPositionTracking Position stored in the tokens of a lexer
+	//
+	//@NONE -> tokens get no line, only their offset which @DialLineIndex can locate
+	//@LINE -> tokens get their line
+	//@LINE_COLUMN -> tokens get their line and column
+	enum class DialPositionTracking {
+		NONE,
+		LINE,
+		LINE_COLUMN
+	};
+
+	//@DialErrorStrategy Handling of content no rule matches
+	//
+	//@THROW -> errors are collected and thrown once the split is done
+	//@SKIP -> unmatched content is skipped without recording anything
+	enum class DialErrorStrategy {
+		THROW,
+		SKIP
+	};
+
+	//@DialDefaultPolicy Compile time configuration of a lexer, derive from it to change some of its members
+	//
+	//@positions position stored in the tokens
+	//@comments determine if comments are supported, the comment checks are compiled out otherwise
+	//@errors handling of content no rule matches
+	//@char_type byte sized character type of the splitted content
+	struct DialDefaultPolicy {
+		static constexpr DialPositionTracking positions = DialPositionTracking::LINE;
+		static constexpr bool comments = true;
+		static constexpr DialErrorStrategy errors = DialErrorStrategy::THROW;
+		using char_type = char;
+	};
+
+	//@BasicDialLexer Lexer class for validating and  splitting input based on predefined token rules
+	//
+	//@TokenType user defined token type of the rules
+	//@Policy compile time configuration, see @DialDefaultPolicy
+	//
+	template <typename TokenType, typename Policy = DialDefaultPolicy>
+	class BasicDialLexer {
+		static_assert(sizeof(typename Policy::char_type) == 1, "the lexer splits byte sized characters");
+
+	public:
+		//@MAX_RESERVED_TOKENS most tokens an empty output is pre-sized for, larger outputs grow as tokens are kept
+		static constexpr size_t MAX_RESERVED_TOKENS = size_t(1) << 20;
+
+		using char_type = typename Policy::char_type;
+		using Token = BasicToken<TokenType>;
+		using TokenFilter = BasicTokenFilter<TokenType>;
+		using SplitOptions = BasicSplitOptions<TokenType>;
+		using DialBatchResult = BasicDialBatchResult<TokenType>;
+#if defined(DIAL_LEXER_COROUTINES)
+		using TokenStream = BasicDialTokenStream<TokenType>;
+#endif
+
+		//@add_token method to add a token to a  list @input_tokens
+		//
+		//@token token to be added to @input_tokens 
+		void add_token(Token token)
+		{
+			this->input_tokens.push_back(std::move(token));
+			this->compiled = false;
+			this->spec_loaded = false;
+			this->loaded_dfa.reset();
+		}
+
+		//@set_raw_engine choose the rule runner of a raw lexer
+		//
+		//@engine rule runner to be used
+		void set_raw_engine(DialRawEngine engine)
+		{
+			this->raw_engine = engine;
+		}
+
+		//@program get the bytecode of the rules, the lexer is compiled if needed
+		//
+		const DialProgram& program()
+		{
+			compile();
+			return raw_program;
+		}
+
+		//@load_program replace the spec of a raw lexer by @program and run it on the bytecode engine
+		//the program is trusted so the spec is not validated again, except that a program with comments
+		//throws when the lexer policy has no comments
+		//
+		//@program program built by another lexer, usually deserialized
+		void load_program(const DialProgram& program)
+		{
+			if (!Policy::comments && !program.comment_begin.empty()) {
+				throw DialLexerException("comments are disabled by the lexer policy", 0, 0, true);
+			}
+			this->type = LexerType::RAW;
+			this->input_tokens.clear();
+			for (size_t rule = 0; rule < program.rules.size(); rule++) {
+				this->input_tokens.emplace_back(static_cast<TokenType>(program.rules[rule].type), string(program.lexeme(rule)),
+					static_cast<DIAL_LEXER_VALUE>(program.rules[rule].value));
+			}
+			this->comment_begin = program.comment_begin;
+			this->comment_end = program.comment_end;
+			this->keyword_mode = program.keyword_mode;
+			this->raw_program = program;
+			this->raw_engine = DialRawEngine::BYTECODE;
+			this->compiled = false;
+			this->spec_loaded = true;
+		}
+
+		//@from_spec build and compile a lexer from a text spec, throws with the line of every spec error
+		//see @BasicDialSpecParser for the format
+		//
+		//@text content of the spec
+		//@types token type of each name used by the rules
+		static BasicDialLexer from_spec(std::string_view text, const std::unordered_map<string, TokenType>& types)
+		{
+			BasicDialSpec<TokenType> spec = BasicDialSpecParser<TokenType>::parse(text, types, Policy::comments);
+			BasicDialLexer lexer(spec.type);
+			for (Token& token : spec.tokens) {
+				lexer.add_token(std::move(token));
+			}
+			if constexpr (Policy::comments) {
+				if (!spec.comment_begin.empty()) {
+					lexer.set_comment(spec.comment_begin, spec.comment_end);
+				}
+			}
+			lexer.set_keyword_mode(spec.keyword_mode);
+			lexer.set_regex_engine(spec.regex_engine);
+			lexer.compile();
+			return lexer;
+		}
+
+		//@save_image write the compiled spec into a versioned image, the lexer is compiled if needed
+		//raw lexers store their program, regex lexers store their rules and the tables of their DFA
+		//
+		string save_image()
+		{
+			compile();
+			DialImageHeader header;
+			header.lexer_type = static_cast<uint32_t>(type);
+			header.regex_engine = static_cast<uint32_t>(regex_engine);
+			header.cache_bytes = dfa_cache_bytes;
+			string image(sizeof(header), '\0');
+			auto align = [&]() { image.resize((image.size() + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t), '\0'); };
+			string spec = type == LexerType::RAW ? raw_program.serialize() : save_rules();
+			header.spec_offset = static_cast<uint32_t>(image.size());
+			header.spec_size = static_cast<uint32_t>(spec.size());
+			image.append(spec);
+			align();
+			if (regex_dfa) {
+				header.dfa_offset = static_cast<uint32_t>(image.size());
+				regex_dfa->save(image);
+				header.dfa_size = static_cast<uint32_t>(image.size() - header.dfa_offset);
+				align();
+			}
+			std::memcpy(&image[0], &header, sizeof(header));
+			return image;
+		}
+
+		//@load_image replace the spec by the one of an image written by @save_image, throws when it is malformed
+		//the image is copied once, its tables are then used in place
+		//
+		//@image image to be loaded
+		void load_image(std::string_view image)
+		{
+			auto buffer = std::make_shared<vector<uint64_t>>((image.size() + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+			std::memcpy(buffer->data(), image.data(), image.size());
+			attach_image(reinterpret_cast<const char*>(buffer->data()), image.size(), buffer);
+		}
+
+		//@map_image replace the spec by the one of the image file at @path, throws when it is malformed
+		//the file is mapped read only so processes loading the same image share its tables through the page cache
+		//
+		//@path path of an image written by @save_image
+		void map_image(const string& path)
+		{
+			std::shared_ptr<const DialMappedFile> file = DialMappedFile::open(path);
+			attach_image(file->data(), file->size(), file);
+		}
+
+		//@set_keyword_mode classify identifier shaped keywords after scanning the whole identifier
+		//when enabled, a run of identifier characters is scanned once and looked up in a keyword table built
+		//at compile time, so `iffy` is one identifier instead of `if` followed by `fy`
+		//
+		//@enabled determine if the mode is used by the raw lexer
+		void set_keyword_mode(bool enabled)
+		{
+			this->keyword_mode = enabled;
+			this->compiled = false;
+			this->spec_loaded = false;
+		}
+
+		//@set_regex_engine choose the matcher of a regex lexer
+		//patterns the automata can't compile fall back to std::regex, a DFA growing too large falls back to the lazy DFA
+		//
+		//@engine matcher to be used
+		//@cache_bytes memory budget of the states cached by the lazy DFA
+		void set_regex_engine(DialRegexEngine engine, size_t cache_bytes = DialLazyDfa::DEFAULT_CACHE_BYTES)
+		{
+			this->regex_engine = engine;
+			this->dfa_cache_bytes = cache_bytes;
+			this->compiled = false;
+			this->loaded_dfa.reset();
+		}
+
+		//@regex_stats get the engine in use and the footprint of its automaton, the lexer is compiled if needed
+		//
+		DialRegexStats regex_stats()
+		{
+			compile();
+			DialRegexStats stats;
+			stats.engine = active_regex_engine;
+			if (regex_nfa) {
+				stats.nfa_states = regex_nfa->states.size();
+			}
+			if (active_regex_engine == DialRegexEngine::LAZY_DFA) {
+				lazy_dfa.fill_stats(stats);
+			}
+			if (active_regex_engine == DialRegexEngine::DFA) {
+				regex_dfa->fill_stats(stats);
+			}
+			if (active_regex_engine == DialRegexEngine::HYBRID) {
+				regex_hybrid->fill_stats(stats);
+			}
+			if (active_regex_engine == DialRegexEngine::SHIFT_OR) {
+				regex_shift_or->fill_stats(stats);
+			}
+			return stats;
+		}
+
+		//@memory_usage estimate the bytes held by the compiled lexer
+		//the automata of a regex lexer are shared between its copies but counted here
+		//
+		size_t memory_usage() const
+		{
+			size_t bytes = sizeof(BasicDialLexer);
+			for (const Token& token : input_tokens) {
+				bytes += sizeof(Token) + token.get_lexeme().capacity();
+			}
+			bytes += raw_program.code.capacity() * sizeof(uint32_t) + raw_program.entries.capacity() * sizeof(uint32_t) +
+				raw_program.rules.capacity() * sizeof(DialProgram::Rule) + raw_program.pool.capacity();
+			bytes += dispatch_rules.capacity() * sizeof(uint32_t) + keyword_table.size() * sizeof(std::pair<string, int>);
+			DialRegexStats stats;
+			if (regex_nfa) {
+				bytes += regex_nfa->states.capacity() * sizeof(DialNfa::State);
+			}
+			if (regex_dfa) {
+				regex_dfa->fill_stats(stats);
+			}
+			else if (regex_hybrid) {
+				regex_hybrid->fill_stats(stats);
+			}
+			else if (regex_shift_or) {
+				regex_shift_or->fill_stats(stats);
+			}
+			else if (active_regex_engine == DialRegexEngine::LAZY_DFA) {
+				stats.table_bytes = dfa_cache_bytes;
+			}
+			return bytes + stats.table_bytes;
+		}
+
+		//@split method to split a source content @raw based on the lexer type
+		//
+		//@raw source content to be splitted 
+		vector<Token> split(std::string_view raw)
+		{
+			return split(raw, SplitOptions());
+		}
+
+		//@split method to split a source content @raw made of the character type of the policy
+		//
+		//@raw source content to be splitted
+		//@options filter, limits and stop predicate for the content
+		template <typename C = char_type, typename = std::enable_if_t<!std::is_same_v<C, char>>>
+		vector<Token> split(std::basic_string_view<C> raw, const SplitOptions& options = SplitOptions())
+		{
+			return split(std::string_view(reinterpret_cast<const char*>(raw.data()), raw.size()), options);
+		}
+
+		//@split method to split a source content @raw keeping only tokens wanted by @filter
+		//unwanted tokens are scanned past without being built
+		//
+		//@raw source content to be splitted
+		//@filter set of wanted token types and values
+		vector<Token> split(std::string_view raw, const TokenFilter& filter)
+		{
+			SplitOptions options;
+			options.filter = filter;
+			return split(raw, options);
+		}
+
+		//@split method to split a source content @raw stopping as soon as @options are satisfied
+		//the rest of @raw is neither scanned nor validated once lexing stops
+		//
+		//@raw source content to be splitted
+		//@options filter, limits and stop predicate for this split
+		vector<Token> split(std::string_view raw, const SplitOptions& options)
+		{
+			vector<Token> tokens;
+			split_into(raw, tokens, options);
+			return tokens;
+		}
+
+		//@split_into method to split a source content @raw into @tokens
+		//the capacity of @tokens and the lexeme storage of the tokens it already holds are reused,
+		//an empty @tokens is pre-sized from the bytes per token seen by previous splits, bounded by the limits of @options
+		//and by @MAX_RESERVED_TOKENS
+		//
+		//@raw source content to be splitted
+		//@tokens container replaced by the splitted tokens
+		//@options filter, limits and stop predicate for this split
+		void split_into(std::string_view raw, vector<Token>& tokens, const SplitOptions& options = SplitOptions())
+		{
+			if (tokens.empty() && bytes_per_token > 0) {
+				size_t bytes = options.max_bytes > 0 ? std::min(raw.size(), options.max_bytes) : raw.size();
+				size_t estimate = static_cast<size_t>(bytes / bytes_per_token) + 1;
+				if (options.max_tokens > 0) {
+					estimate = std::min(estimate, options.max_tokens);
+				}
+				tokens.reserve(std::min(estimate, MAX_RESERVED_TOKENS));
+			}
+			lex(raw, options, tokens, 0);
+		}
+
+		//@split_slice method to split the next slice of @raw, of about @slice_bytes, into @tokens
+		//no token starts past the slice so a token may end after it, lexer errors are collected into @state
+		//instead of being thrown so the content can be resumed
+		//
+		//@raw source content to be splitted, must be the same content on every call for the same @state
+		//@state resumable position updated by the call
+		//@slice_bytes number of bytes tokens may start from in this slice
+		//@options filter, limits and stop predicate for the whole content
+		//@tokens container the kept tokens are appended to
+		bool split_slice(std::string_view raw, SplitState& state, size_t slice_bytes, const SplitOptions& options, vector<Token>& tokens)
+		{
+			if (state.finished) {
+				return true;
+			}
+			compile();
+			DialLexerException* previous_sink = error_sink;
+			error_sink = &state.errors;
+			try {
+				lex(raw, options, tokens, tokens.size(), state.position, state.line, state.position + std::max<size_t>(slice_bytes, 1), state.token_count);
+			}
+			catch (const DialLexerException&) {
+				state.has_error = true;
+			}
+			error_sink = previous_sink;
+			state.position = current;
+			state.line = line_at(current);
+			state.token_count += output_count - output_start;
+			state.finished = stop_requested || current >= get_eof() || (options.max_bytes > 0 && current >= options.max_bytes);
+			return state.finished;
+		}
+
+#if defined(DIAL_LEXER_COROUTINES)
+		//@split_async method to split the content of @reader while it is being read, suspending at each buffer boundary
+		//a buffer is splitted with @split_slice up to its last complete line, or its last blank when it holds no newline,
+		//and the tokens are handed out by the stream. a token, comment or error running past that point is splitted again
+		//from its start once more content is read, no sooner than when the pending content has doubled so a token spanning
+		//many buffers is splitted a bounded number of times.
+		//the lexer must outlive the stream, streams of one lexer may be interleaved on a single thread
+		//
+		//@reader asynchronous source, co_await reader.read(buffer, size) gives the number of bytes read, 0 at the end
+		//@filter set of wanted token types and values
+		//@buffer_bytes number of bytes asked to @reader at once
+		template <typename Reader>
+		TokenStream split_async(Reader& reader, TokenFilter filter = TokenFilter(), size_t buffer_bytes = 1 << 16)
+		{
+			SplitOptions options;
+			options.filter = std::move(filter);
+			SplitState state;
+			string buffer;
+			vector<Token> tokens;
+			//@base offset of @buffer in the content, @column_shift bytes of the first line of @buffer already erased
+			size_t base = 0, column_shift = 0, retry_size = 0;
+			bool at_end = false;
+			while (!state.finished) {
+				if (!at_end) {
+					size_t size = buffer.size();
+					buffer.resize(size + buffer_bytes);
+					size_t read = co_await reader.read(buffer.data() + size, buffer_bytes);
+					buffer.resize(size + read);
+					at_end = read == 0;
+				}
+				if (at_end && state.position >= buffer.size()) {
+					break;
+				}
+				if (!at_end && buffer.size() < retry_size) {
+					continue;
+				}
+				//the last byte is kept for the next read so a split never reaches the end of @buffer early
+				size_t cut = buffer.size();
+				if (!at_end) {
+					cut = buffer.size() < 2 ? 0 : buffer.rfind('\n', buffer.size() - 2) + 1;
+					if (cut <= state.position) {
+						cut = buffer.size() < 2 ? 0 : buffer.find_last_of(" \t\r", buffer.size() - 2) + 1;
+					}
+				}
+				if (cut <= state.position) {
+					continue;
+				}
+				SplitState attempt = state;
+				tokens.clear();
+				split_slice(buffer, attempt, cut - attempt.position, options, tokens);
+				if (!at_end && attempt.position > cut) {
+					//keep the tokens before the one running past the cut and resume from the end of the last kept one
+					size_t resume = state.position;
+					if (!attempt.has_error) {
+						if (!tokens.empty() && tokens.back().get_offset() + tokens.back().get_lexeme().size() > cut) {
+							tokens.pop_back();
+						}
+						if (!tokens.empty()) {
+							resume = tokens.back().get_offset() + tokens.back().get_lexeme().size();
+						}
+					}
+					if (resume <= state.position) {
+						tokens.clear();
+						retry_size = buffer.size() + (buffer.size() - state.position);
+						continue;
+					}
+					attempt.position = resume;
+					attempt.line = state.line + std::count(buffer.begin() + state.position, buffer.begin() + resume, '\n');
+					attempt.token_count = state.token_count + tokens.size();
+					attempt.finished = false;
+				}
+				else if (attempt.has_error) {
+					throw attempt.errors;
+				}
+				retry_size = 0;
+				for (Token& token : tokens) {
+					if (token.get_line() == state.line && token.get_column() > 0) {
+						token.set_column(token.get_column() + column_shift);
+					}
+					token.set_offset(token.get_offset() + base);
+				}
+				state = std::move(attempt);
+				if (!tokens.empty()) {
+					co_yield tokens;
+				}
+				size_t consumed = state.position;
+				size_t newline = consumed > 0 ? buffer.rfind('\n', consumed - 1) : string::npos;
+				column_shift = newline == string::npos ? column_shift + consumed : consumed - newline - 1;
+				buffer.erase(0, consumed);
+				base += consumed;
+				state.position = 0;
+			}
+		}
+#endif
+
+		//@split_batch method to split many source contents @inputs over a work stealing thread pool
+		//each worker reuses its own copy of the compiled lexer, errors are reported per document
+		//
+		//@inputs source contents to be splitted
+		//@options filter, limits and stop predicate applied to every document
+		//@pool thread pool running the documents
+		vector<DialBatchResult> split_batch(const vector<std::string_view>& inputs, const SplitOptions& options = SplitOptions(),
+			DialThreadPool& pool = DialThreadPool::shared())
+		{
+			vector<DialBatchResult> results;
+			split_batch_into(inputs, results, options, pool);
+			return results;
+		}
+
+		//@split_batch_into method to split many source contents @inputs into @results over a work stealing thread pool
+		//the copies of the compiled lexer made for the workers are kept until the lexer is compiled again, so they
+		//keep the bytes per token they learned, the token storage already held by @results is reused
+		//
+		//@inputs source contents to be splitted
+		//@results results replaced by one result per document
+		//@options filter, limits and stop predicate applied to every document
+		//@pool thread pool running the documents
+		void split_batch_into(const vector<std::string_view>& inputs, vector<DialBatchResult>& results,
+			const SplitOptions& options = SplitOptions(), DialThreadPool& pool = DialThreadPool::shared())
+		{
+			compile();
+			vector<std::unique_ptr<BasicDialLexer>>& workers = batch_workers.lexers;
+			while (workers.size() < pool.size()) {
+				workers.push_back(std::make_unique<BasicDialLexer>(*this));
+			}
+			results.resize(inputs.size());
+			pool.run(inputs.size(), [&](size_t task, size_t worker) {
+				BasicDialLexer& lexer = *workers[worker];
+				DialBatchResult& result = results[task];
+				result.has_error = false;
+				result.error.clear();
+				DialLexerException document_exception;
+				lexer.error_sink = &document_exception;
+				try {
+					lexer.split_into(inputs[task], result.tokens, options);
+				}
+				catch (const std::exception& ex) {
+					result.has_error = true;
+					result.error = ex.what();
+				}
+				lexer.error_sink = &lex_exception;
+			});
+		}
+
+		//@compile validate @input_tokens and build the state shared by every split
+		//called by split whenever the tokens or comments changed since the last compile
+		//
+		void compile()
+		{
+			if (compiled) {
+				return;
+			}
+			batch_workers.lexers.clear();
+			reset_state();
+			string exception_message = "";
+			if (this->type == LexerType::RAW) {
+				if (spec_loaded) {
+					unknown_identifiers = raw_program.identifiers;
+				}
+				else if (!verify_raw_tokens_integrity(input_tokens, exception_message, unknown_identifiers, comment_begin, comment_end)) {
+					throw DialLexerException(exception_message, line, current, true);
+				}
+				//the first rule of each semantic value, found in one pass
+				std::array<const Token*, 6> value_rules{};
+				for (auto rule = input_tokens.rbegin(); rule != input_tokens.rend(); ++rule) {
+					if (static_cast<size_t>(rule->get_value()) < value_rules.size()) {
+						value_rules[static_cast<size_t>(rule->get_value())] = &*rule;
+					}
+				}
+				const Token* end_rule = value_rules[static_cast<size_t>(DIAL_LEXER_VALUE::DIAL_STRING_END)];
+				const Token* number_rule = value_rules[static_cast<size_t>(DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE)];
+				const Token* identifier_rule = value_rules[static_cast<size_t>(DIAL_LEXER_VALUE::DIAL_IDENTIFIER)];
+				end_token = end_rule ? *end_rule : Token{};
+				has_number_rule = number_rule != nullptr;
+				has_identifier_rule = identifier_rule != nullptr;
+				number_type = number_rule ? number_rule->get_type() : TokenType();
+				identifier_type = identifier_rule ? identifier_rule->get_type() : TokenType();
+				compile_identifiers();
+				compile_keywords();
+				compile_literals();
+				compile_dispatch();
+				if (!spec_loaded) {
+					build_program();
+				}
+			}
+			else {
+				if (!spec_loaded && !verify_regex_tokens_integrity(input_tokens, exception_message)) {
+					throw DialLexerException(exception_message, line, current, true);
+				}
+				compile_regex();
+			}
+			compiled = true;
+		}
+
+		//@Lexer-constructor takes in a lexer type defaulted at @raw
+		//
+		//@type type of lexer to be used for splitting
+		BasicDialLexer(LexerType type = LexerType::RAW) : type(type)
+		{
+		}
+
+		//@input_token_size get the size of input token list
+		//
+		size_t input_token_size()
+		{
+			return input_tokens.size();
+		}
+		
+		//@set_comment set the value of @comment_begin and @comment_end
+		//
+		//@begin begining of comment token
+		//@end end of comment token
+		void set_comment(string begin, string end = "\n") {
+			static_assert(Policy::comments, "comments are disabled by the lexer policy");
+			this->comment_begin = std::move(begin);
+			this->comment_end = std::move(end);
+			this->compiled = false;
+			this->spec_loaded = false;
+		}
+	private:
+		LexerType type;
+		bool compiled = false;
+		std::regex compiled_regex;
+		vector<size_t> regex_rule_groups;
+		DialRawEngine raw_engine = DialRawEngine::LOOP;
+		DialProgram raw_program;
+		bool spec_loaded = false;
+		DialRegexEngine regex_engine = DialRegexEngine::AUTO, active_regex_engine = DialRegexEngine::STD_REGEX;
+		size_t dfa_cache_bytes = DialLazyDfa::DEFAULT_CACHE_BYTES;
+		std::shared_ptr<const DialNfa> regex_nfa;
+		std::shared_ptr<const DialDfa> regex_dfa, loaded_dfa;
+		std::shared_ptr<const DialHybridMatcher> regex_hybrid;
+		std::shared_ptr<const DialShiftOrMatcher> regex_shift_or;
+		DialLazyDfa lazy_dfa;
+		DialBytePrefilter regex_prefilter;
+		static constexpr unsigned char IDENTIFIER_START = 1, IDENTIFIER_CONTINUE = 2;
+		std::array<unsigned char, 256> identifier_classes{};
+		bool keyword_mode = false, has_number_rule = false, has_identifier_rule = false, wanted_number = true, wanted_identifier = true;
+		DialKeywordTable keyword_table;
+		DialLiteralTrie literal_trie;
+		size_t literal_group = 0;
+		std::array<uint32_t, 257> dispatch_offsets{};
+		vector<uint32_t> dispatch_rules;
+		vector<string> identifier_fragments;
+		std::cmatch matcher;
+		Token end_token;
+		TokenType number_type = TokenType(), identifier_type = TokenType();
+		DialLexerException* error_sink = &lex_exception;
+		std::string_view source;
+		size_t current = 0;
+		int64_t line = 1;
+		string comment_begin = "", comment_end = "";
+		const SplitOptions* split_options = nullptr;
+		vector<bool> wanted_rules, wanted_types;
+		std::array<bool, 6> wanted_values{};
+		bool filter_all = true;
+		size_t line_offset = 0, line_begin = 0;
+		bool stop_requested = false, slice_paused = false;
+		size_t slice_start = 0, slice_end = 0, kept_before = 0;
+
+		//@advance move by one char in @source content
+		//
+		char advance()
+		{
+			++current;
+			return current < get_eof() ? this->source[current] : -1;
+		}
+
+		//@peek look ahead at position 1 from @source
+		//
+		char peek()
+		{
+			return peek_lookahead(1);
+		}
+		bool has_error = false;
+
+		//@match match the current character from @source with an expected character
+		//
+		//@expected a function implementing @source operation 
+		bool match(char expected)
+		{
+			return current < get_eof() ? this->source[current] == expected : false;
+		}
+		//@match_comment match the current character from @source with a comment start or end token
+		//
+		//@handle_start a condition representing matching start or end comment
+		bool match_comment(bool handle_start) {
+			const string& lex = handle_start ? this->comment_begin : this->comment_end;
+			if (!lex.empty() && is_eof()) {
+				has_error = has_error || !handle_start;
+				return false;
+			}
+			return match_word(lex);
+		}
+
+		//@match_word match the current characters from @source with  expected characters
+		//
+		//@word word to be matched against
+		bool match_word(std::string_view word) const {
+			return word.empty() || (current + word.size() <= source.size() && source.compare(current, word.size(), word) == 0);
+		}
+
+		//@match_identifier_length length of the identifier starting from current character
+		//scans @identifier_classes and @identifier_fragments in a single pass
+		//
+		size_t match_identifier_length() const {
+			const unsigned char* data = reinterpret_cast<const unsigned char*>(source.data());
+			size_t position = current, end = source.size();
+			unsigned char wanted_class = IDENTIFIER_START;
+			while (position < end) {
+				if (identifier_classes[data[position]] & wanted_class) {
+					position++;
+					while (position < end && (identifier_classes[data[position]] & IDENTIFIER_CONTINUE)) {
+						position++;
+					}
+					wanted_class = IDENTIFIER_CONTINUE;
+					continue;
+				}
+				const string* fragment_matched = nullptr;
+				for (const string& fragment : identifier_fragments) {
+					if (position + fragment.size() <= end && source.compare(position, fragment.size(), fragment) == 0) {
+						fragment_matched = &fragment;
+						break;
+					}
+				}
+				if (fragment_matched == nullptr) {
+					break;
+				}
+				position += fragment_matched->size();
+				wanted_class = IDENTIFIER_CONTINUE;
+			}
+			return position - current;
+		}
+
+		//@compile_identifiers build @identifier_classes and @identifier_fragments from @unknown_identifiers
+		//the special constants and one character fragments become character classes, longer fragments
+		//are kept as literals
+		//
+		void compile_identifiers()
+		{
+			identifier_classes.fill(0);
+			identifier_fragments.clear();
+			unsigned char both = IDENTIFIER_START | IDENTIFIER_CONTINUE;
+			for (const string& lexeme : unknown_identifiers) {
+				bool alnum = lexeme == IS_IDENTIFIER_ALPHA_NUM;
+				for (int c = 0; c < 256; c++) {
+					bool digit = c >= '0' && c <= '9', lower = c >= 'a' && c <= 'z', upper = c >= 'A' && c <= 'Z';
+					if ((alnum && (digit || lower || upper)) || (lexeme == IS_IDENTIFIER_ALPHA_LOWER && lower) || (lexeme == IS_IDENTIFIER_ALPHA_UPPER && upper)) {
+						identifier_classes[c] |= both;
+					}
+				}
+				if (lexeme == IS_IDENTIFIER_ALPHA_NUM || lexeme == IS_IDENTIFIER_ALPHA_LOWER || lexeme == IS_IDENTIFIER_ALPHA_UPPER) {
+					continue;
+				}
+				if (lexeme.size() == 1) {
+					identifier_classes[static_cast<unsigned char>(lexeme[0])] |= both;
+				}
+				else if (!lexeme.empty()) {
+					identifier_fragments.push_back(lexeme);
+				}
+			}
+		}
+
+		//@compile_regex build the matcher chosen by @regex_engine, std::regex when the patterns need it
+		//
+		void compile_regex()
+		{
+			vector<string> lexemes;
+			for (const Token& token : input_tokens) {
+				lexemes.push_back(token.get_lexeme());
+			}
+			choose_regex_engine(lexemes);
+			DialByteSet first_bytes;
+			if (regex_hybrid || regex_shift_or || regex_dfa) {
+				for (int c = 0; c < 256; c++) {
+					unsigned char byte = static_cast<unsigned char>(c);
+					if (regex_hybrid ? regex_hybrid->starts(byte) : regex_shift_or ? regex_shift_or->starts(byte) : regex_dfa->starts(byte)) {
+						first_bytes.add(byte);
+					}
+				}
+			}
+			else if (regex_nfa) {
+				DialNfaSimulator simulator;
+				simulator.reset(regex_nfa.get());
+				vector<int> start_states;
+				simulator.start(start_states);
+				for (int state : start_states) {
+					if (regex_nfa->states[state].kind == DialNfa::Kind::BYTES) {
+						first_bytes.merge(regex_nfa->states[state].bytes);
+					}
+				}
+			}
+			regex_prefilter.build(first_bytes);
+		}
+
+		//@save_rules write the input tokens of a regex lexer into an image section
+		//
+		string save_rules() const
+		{
+			string section;
+			auto put = [&](uint32_t word) { section.append(reinterpret_cast<const char*>(&word), sizeof(word)); };
+			put(static_cast<uint32_t>(input_tokens.size()));
+			for (const Token& token : input_tokens) {
+				put(static_cast<uint32_t>(token.get_type()));
+				put(static_cast<uint32_t>(token.get_value()));
+				put(static_cast<uint32_t>(token.get_lexeme().size()));
+				section.append(token.get_lexeme());
+			}
+			return section;
+		}
+
+		//@load_rules read the input tokens written by @save_rules into @tokens, false when @section is malformed
+		//
+		static bool load_rules(std::string_view section, vector<Token>& tokens)
+		{
+			size_t position = 0;
+			auto get = [&](uint32_t& word) {
+				if (section.size() - position < sizeof(word)) {
+					return false;
+				}
+				std::memcpy(&word, section.data() + position, sizeof(word));
+				position += sizeof(word);
+				return true;
+			};
+			uint32_t count = 0;
+			if (!get(count)) {
+				return false;
+			}
+			for (uint32_t i = 0; i < count; i++) {
+				uint32_t token_type = 0, value = 0, size = 0;
+				if (!get(token_type) || !get(value) || !get(size) || value > static_cast<uint32_t>(DIAL_LEXER_VALUE::DIAL_STRING) ||
+					section.size() - position < size) {
+					return false;
+				}
+				tokens.emplace_back(static_cast<TokenType>(token_type), string(section.substr(position, size)), static_cast<DIAL_LEXER_VALUE>(value));
+				position += size;
+			}
+			return position == section.size();
+		}
+
+		//@attach_image load the image at @data, its tables stay where they are
+		//
+		//@data image written by @save_image, aligned on 8 bytes
+		//@size size of the image
+		//@owner memory holding @data, kept alive as long as the tables are used
+		void attach_image(const char* data, size_t size, std::shared_ptr<const void> owner)
+		{
+			DialImageHeader header;
+			auto fail = [&]() { return DialLexerException("invalid lexer image", 0, 0, true); };
+			if (size < sizeof(header)) {
+				throw fail();
+			}
+			std::memcpy(&header, data, sizeof(header));
+			bool valid = header.magic == DialImageHeader::MAGIC && header.version == DialImageHeader::VERSION &&
+				header.lexer_type <= static_cast<uint32_t>(LexerType::RAW) && header.regex_engine <= static_cast<uint32_t>(DialRegexEngine::SHIFT_OR) &&
+				header.spec_offset <= size && header.spec_size <= size - header.spec_offset &&
+				header.dfa_offset <= size && header.dfa_size <= size - header.dfa_offset && header.dfa_offset % sizeof(uint64_t) == 0;
+			if (!valid) {
+				throw fail();
+			}
+			std::string_view spec(data + header.spec_offset, header.spec_size);
+			if (static_cast<LexerType>(header.lexer_type) == LexerType::RAW) {
+				load_program(DialProgram::deserialize(spec));
+				return;
+			}
+			vector<Token> tokens;
+			if (!load_rules(spec, tokens)) {
+				throw fail();
+			}
+			std::shared_ptr<DialDfa> dfa;
+			if (header.dfa_size > 0) {
+				dfa = std::make_shared<DialDfa>();
+				if (!dfa->attach(data + header.dfa_offset, header.dfa_size, tokens.size(), std::move(owner))) {
+					throw fail();
+				}
+			}
+			this->type = LexerType::REGEX;
+			this->input_tokens = std::move(tokens);
+			this->regex_engine = static_cast<DialRegexEngine>(header.regex_engine);
+			this->dfa_cache_bytes = static_cast<size_t>(header.cache_bytes);
+			this->loaded_dfa = dfa;
+			this->compiled = false;
+			this->spec_loaded = true;
+		}
+
+		//@choose_regex_engine build the matcher chosen by @regex_engine for @lexemes
+		//
+		void choose_regex_engine(const vector<string>& lexemes)
+		{
+			regex_nfa.reset();
+			regex_dfa.reset();
+			regex_hybrid.reset();
+			regex_shift_or.reset();
+			active_regex_engine = DialRegexEngine::STD_REGEX;
+			//tables loaded from an image are used as they are
+			if (loaded_dfa) {
+				regex_dfa = loaded_dfa;
+				active_regex_engine = DialRegexEngine::DFA;
+				return;
+			}
+			//rules that are all literals or class runs need no automaton at all
+			if (regex_engine == DialRegexEngine::AUTO || regex_engine == DialRegexEngine::HYBRID) {
+				auto hybrid = std::make_shared<DialHybridMatcher>();
+				if (hybrid->build(lexemes, regex_engine == DialRegexEngine::HYBRID)) {
+					regex_hybrid = hybrid;
+					active_regex_engine = DialRegexEngine::HYBRID;
+					return;
+				}
+			}
+			//small rule sets skip the automaton construction
+			if (regex_engine == DialRegexEngine::AUTO || regex_engine == DialRegexEngine::SHIFT_OR) {
+				auto shift_or = std::make_shared<DialShiftOrMatcher>();
+				if (shift_or->build(lexemes)) {
+					regex_shift_or = shift_or;
+					active_regex_engine = DialRegexEngine::SHIFT_OR;
+					return;
+				}
+			}
+			if (regex_engine != DialRegexEngine::STD_REGEX) {
+				auto nfa = std::make_shared<DialNfa>();
+				if (DialRegexCompiler::compile(lexemes, *nfa)) {
+					regex_nfa = nfa;
+					auto dfa = std::make_shared<DialDfa>();
+					if (regex_engine != DialRegexEngine::LAZY_DFA && dfa->build(*nfa)) {
+						regex_dfa = dfa;
+						active_regex_engine = DialRegexEngine::DFA;
+						return;
+					}
+					lazy_dfa.reset(nfa, dfa_cache_bytes);
+					active_regex_engine = DialRegexEngine::LAZY_DFA;
+					return;
+				}
+			}
+			string patterns = "";
+			//the groups of a pattern shift the outer groups of every later rule
+			regex_rule_groups.clear();
+			size_t group = 1;
+			for (const string& lexeme : lexemes) {
+				patterns.append("(").append(lexeme).append(")|");
+				regex_rule_groups.push_back(group);
+				group += 1 + std::regex(lexeme, std::regex::extended).mark_count();
+			}
+			if (!patterns.empty()) {
+				patterns.pop_back();
+			}
+			compiled_regex = std::regex(patterns, std::regex::extended);
+		}
+
+		//@has_gap_content determine if the text skipped between two matches holds anything but whitespaces
+		//
+		static bool has_gap_content(std::string_view gap)
+		{
+			return DialBytePrefilter::find_content(reinterpret_cast<const unsigned char*>(gap.data()), gap.size()) < gap.size();
+		}
+
+		//@find_regex_match find the leftmost match starting from @from and before @end
+		//only the starts are bounded by @end, a match found may run past it
+		//
+		//@from position the search starts from
+		//@end position no match may start from, the size of @source searches everything
+		//@match_start position of the match
+		//@match_length length of the match
+		//@rule position of the input token matched, string::npos when only whitespaces were matched
+		bool find_regex_match(size_t from, size_t end, size_t& match_start, size_t& match_length, size_t& rule)
+		{
+			if (active_regex_engine == DialRegexEngine::STD_REGEX) {
+				const char* last = source.data() + source.size();
+				if (end >= source.size()) {
+					if (!std::regex_search(source.data() + from, last, matcher, compiled_regex)) {
+						return false;
+					}
+					match_start = from + matcher.position();
+				}
+				else {
+					//std::regex can't bound the starts of a search, each start is tried on its own
+					match_start = from;
+					while (match_start < end && !std::regex_search(source.data() + match_start, last, matcher, compiled_regex, std::regex_constants::match_continuous)) {
+						match_start++;
+					}
+					if (match_start >= end) {
+						return false;
+					}
+				}
+				match_length = matcher.length();
+				rule = get_matched_rule(matcher, regex_rule_groups);
+				return true;
+			}
+			const unsigned char* data = reinterpret_cast<const unsigned char*>(source.data());
+			for (size_t position = from; position < end; position++) {
+				//jump to the next byte a match can start with
+				position += regex_prefilter.find(data + position, end - position);
+				if (position >= end) {
+					break;
+				}
+				int matched = -1;
+				if (regex_hybrid) {
+					matched = regex_hybrid->match(data + position, source.size() - position, match_length);
+				}
+				else if (regex_shift_or) {
+					matched = regex_shift_or->match(data + position, source.size() - position, match_length);
+				}
+				else if (regex_dfa) {
+					matched = regex_dfa->match(data + position, source.size() - position, match_length);
+				}
+				else {
+					matched = lazy_dfa.match(data + position, source.size() - position, match_length);
+				}
+				if (matched >= 0) {
+					match_start = position;
+					//same as std::regex, a match of whitespaces only is not a token
+					rule = has_content(source.substr(position, match_length)) ? static_cast<size_t>(matched) : string::npos;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		//@build_program compile the rules into @raw_program
+		//every rule becomes the instructions the rule loop of @raw_splitter would run for it
+		//
+		void build_program()
+		{
+			raw_program = DialProgram();
+			raw_program.comment_begin = comment_begin;
+			raw_program.comment_end = comment_end;
+			raw_program.keyword_mode = keyword_mode;
+			raw_program.identifiers = unknown_identifiers;
+			vector<uint32_t>& code = raw_program.code;
+			auto emit = [&](DialOpcode opcode) { code.push_back(static_cast<uint32_t>(opcode)); };
+			auto emit_string = [&](const string& value) {
+				code.push_back(raw_program.add_string(value));
+				code.push_back(static_cast<uint32_t>(value.size()));
+			};
+			for (size_t rule = 0; rule < input_tokens.size(); rule++) {
+				const Token& token = input_tokens[rule];
+				DIAL_LEXER_VALUE value = token.get_value();
+				DialProgram::Rule program_rule;
+				program_rule.type = static_cast<int32_t>(token.get_type());
+				program_rule.value = static_cast<uint32_t>(value);
+				program_rule.lexeme_offset = raw_program.add_string(token.get_lexeme());
+				program_rule.lexeme_size = static_cast<uint32_t>(token.get_lexeme().size());
+				raw_program.rules.push_back(program_rule);
+				raw_program.entries.push_back(static_cast<uint32_t>(code.size()));
+				if (is_trie_literal(token)) {
+					if (rule == literal_group) {
+						emit(DialOpcode::LITERALS);
+					}
+					emit(DialOpcode::NEXT);
+					continue;
+				}
+				bool is_string = value == DIAL_LEXER_VALUE::DIAL_STRING_START || value == DIAL_LEXER_VALUE::DIAL_STRING_END;
+				if (!is_string && !token.get_lexeme().empty()) {
+					emit(DialOpcode::LITERAL);
+					emit_string(token.get_lexeme());
+				}
+				switch (value) {
+				case DIAL_LEXER_VALUE::DIAL_STRING_START:
+					emit(DialOpcode::STRING);
+					emit_string(token.get_lexeme());
+					emit_string(end_token.get_lexeme());
+					[[fallthrough]];
+				case DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE:
+					emit(DialOpcode::STOP_CHECK);
+					emit(DialOpcode::NUMBER);
+					[[fallthrough]];
+				case DIAL_LEXER_VALUE::DIAL_IDENTIFIER:
+					emit(DialOpcode::STOP_CHECK);
+					emit(DialOpcode::IDENTIFIER);
+				default:
+					break;
+				}
+				emit(DialOpcode::END_RULE);
+			}
+		}
+
+		//@run_rule run the instructions of rule @rule at the current character, false when the rule loop ends
+		//
+		//@rule position of the input token to be run
+		bool run_rule(size_t rule)
+		{
+			const uint32_t* pc = raw_program.code.data() + raw_program.entries[rule];
+			const char* pool = raw_program.pool.data();
+			const Token& token = input_tokens[rule];
+			bool wanted = wanted_rules[rule];
+#if defined(__GNUC__)
+			static void* const labels[] = { &&op_literals, &&op_literal, &&op_string, &&op_number, &&op_identifier, &&op_stop_check, &&op_next, &&op_end_rule };
+#define DIAL_DISPATCH() goto *labels[*pc]
+#else
+#define DIAL_DISPATCH() switch (static_cast<DialOpcode>(*pc)) { \
+			case DialOpcode::LITERALS: goto op_literals; \
+			case DialOpcode::LITERAL: goto op_literal; \
+			case DialOpcode::STRING: goto op_string; \
+			case DialOpcode::NUMBER: goto op_number; \
+			case DialOpcode::IDENTIFIER: goto op_identifier; \
+			case DialOpcode::STOP_CHECK: goto op_stop_check; \
+			case DialOpcode::NEXT: goto op_next; \
+			default: goto op_end_rule; }
+#endif
+			DIAL_DISPATCH();
+		op_literals: {
+				size_t literal_length = 0;
+				int matched = literal_trie.match(source.substr(current), literal_length);
+				if (matched < 0) {
+					return true;
+				}
+				current += literal_length;
+				if (wanted_rules[matched]) {
+					push_token(input_tokens[matched].get_type(), input_tokens[matched].get_lexeme(), DIAL_LEXER_VALUE::DIAL_NONE);
+				}
+				return false;
+			}
+		op_literal: {
+				std::string_view literal(pool + pc[1], pc[2]);
+				if (match_word(literal)) {
+					current += literal.size();
+					if (wanted) {
+						push_token(token.get_type(), literal, token.get_value());
+					}
+					return false;
+				}
+				pc += 3;
+				DIAL_DISPATCH();
+			}
+		op_string: {
+				std::string_view start_lex(pool + pc[1], pc[2]);
+				if (match_word(start_lex)) {
+					size_t start = current;
+					skip_string(start_lex, std::string_view(pool + pc[3], pc[4]));
+					if (wanted) {
+						emit_token(start, token.get_type(), DIAL_LEXER_VALUE::DIAL_STRING);
+					}
+				}
+				pc += 5;
+				DIAL_DISPATCH();
+			}
+		op_number: {
+				size_t double_length = match_double_length();
+				if (double_length > 0) {
+					size_t start = current;
+					current += double_length;
+					if (wanted_number) {
+						emit_token(start, number_type, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE);
+					}
+				}
+				pc += 1;
+				DIAL_DISPATCH();
+			}
+		op_identifier: {
+				size_t start = current;
+				current += match_identifier_length();
+				if (current != start && wanted_identifier) {
+					emit_token(start, identifier_type, DIAL_LEXER_VALUE::DIAL_IDENTIFIER);
+				}
+				pc += 1;
+				DIAL_DISPATCH();
+			}
+		op_stop_check:
+			if (should_stop()) {
+				return false;
+			}
+			pc += 1;
+			DIAL_DISPATCH();
+		op_next:
+			return true;
+		op_end_rule:
+			return !should_stop();
+#undef DIAL_DISPATCH
+		}
+
+		//@compile_keywords build @keyword_table from the identifier shaped DIAL_NONE tokens
+		//
+		void compile_keywords()
+		{
+			vector<std::pair<string, int>> keywords;
+			if (keyword_mode) {
+				for (size_t i = 0; i < input_tokens.size(); i++) {
+					const string& lexeme = input_tokens[i].get_lexeme();
+					if (input_tokens[i].get_value() == DIAL_LEXER_VALUE::DIAL_NONE && !lexeme.empty() && is_identifier_shaped(lexeme)) {
+						keywords.emplace_back(lexeme, static_cast<int>(i));
+					}
+				}
+			}
+			keyword_table.build(keywords);
+		}
+
+		//@compile_literals build @literal_trie from the DIAL_NONE tokens, the trie is tried at the position of the first one
+		//
+		void compile_literals()
+		{
+			vector<std::pair<string, int>> literals;
+			literal_group = input_tokens.size();
+			for (size_t i = 0; i < input_tokens.size(); i++) {
+				if (is_trie_literal(input_tokens[i])) {
+					literal_group = std::min(literal_group, i);
+					literals.emplace_back(input_tokens[i].get_lexeme(), static_cast<int>(i));
+				}
+			}
+			literal_trie.build(literals);
+		}
+
+		//@compile_dispatch build @dispatch_rules, the rules able to consume a character starting with each byte
+		//a rule is kept when its literal, its string start or any scanner reached through the fallthrough of
+		//the raw lexer switch can start with the byte, so skipping the other rules never changes a result
+		//
+		void compile_dispatch()
+		{
+			vector<vector<uint32_t>> candidates(256);
+			auto add = [&](unsigned char c, size_t rule) {
+				if (candidates[c].empty() || candidates[c].back() != rule) {
+					candidates[c].push_back(static_cast<uint32_t>(rule));
+				}
+			};
+			for (size_t rule = 0; rule < input_tokens.size(); rule++) {
+				const string& lexeme = input_tokens[rule].get_lexeme();
+				DIAL_LEXER_VALUE value = input_tokens[rule].get_value();
+				bool scans_number = value == DIAL_LEXER_VALUE::DIAL_STRING_START || value == DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE;
+				bool scans_identifier = scans_number || value == DIAL_LEXER_VALUE::DIAL_IDENTIFIER;
+				for (int c = 0; c < 256; c++) {
+					unsigned char byte = static_cast<unsigned char>(c);
+					bool starts = false;
+					if (is_trie_literal(input_tokens[rule])) {
+						starts = rule == literal_group && literal_trie.starts(byte);
+					}
+					else if (!lexeme.empty() && value != DIAL_LEXER_VALUE::DIAL_STRING_END) {
+						starts = static_cast<unsigned char>(lexeme[0]) == byte;
+					}
+					starts = starts || (scans_number && (c == '-' || c == '.' || (c >= '0' && c <= '9')));
+					starts = starts || (scans_identifier && (identifier_classes[byte] & IDENTIFIER_START));
+					if (scans_identifier) {
+						for (const string& fragment : identifier_fragments) {
+							starts = starts || static_cast<unsigned char>(fragment[0]) == byte;
+						}
+					}
+					if (starts) {
+						add(byte, rule);
+					}
+				}
+			}
+			dispatch_rules.clear();
+			for (int c = 0; c < 256; c++) {
+				dispatch_offsets[c] = static_cast<uint32_t>(dispatch_rules.size());
+				dispatch_rules.insert(dispatch_rules.end(), candidates[c].begin(), candidates[c].end());
+			}
+			dispatch_offsets[256] = static_cast<uint32_t>(dispatch_rules.size());
+		}
+
+		//@next_candidate get the first rule from @from able to consume the current character, the rule count when none
+		//
+		//@from smallest rule position to be returned
+		size_t next_candidate(size_t from) const
+		{
+			if (current >= source.size()) {
+				return input_tokens.size();
+			}
+			unsigned char c = static_cast<unsigned char>(source[current]);
+			const uint32_t* first = dispatch_rules.data() + dispatch_offsets[c];
+			const uint32_t* last = dispatch_rules.data() + dispatch_offsets[c + 1];
+			const uint32_t* candidate = std::lower_bound(first, last, static_cast<uint32_t>(from));
+			return candidate != last ? *candidate : input_tokens.size();
+		}
+
+		//@is_trie_literal determine if @token is matched through @literal_trie
+		//
+		static bool is_trie_literal(const Token& token)
+		{
+			return token.get_value() == DIAL_LEXER_VALUE::DIAL_NONE && !token.get_lexeme().empty();
+		}
+
+		//@is_identifier_shaped determine if the identifier scanner would match all of @word
+		//
+		//@word word to be checked
+		bool is_identifier_shaped(const string& word)
+		{
+			std::string_view previous_source = source;
+			size_t previous_current = current;
+			source = word;
+			current = 0;
+			bool shaped = match_identifier_length() == word.size();
+			source = previous_source;
+			current = previous_current;
+			return shaped;
+		}
+
+		//@match_keyword_or_identifier split the identifier run at the current character as a keyword or an identifier
+		//digits are left to the rule loop when the spec has a number token
+		//
+		bool match_keyword_or_identifier()
+		{
+			unsigned char c = static_cast<unsigned char>(peek_lookahead(0));
+			if (c >= '0' && c <= '9' && has_number_rule) {
+				return false;
+			}
+			size_t length = match_identifier_length();
+			if (length == 0) {
+				return false;
+			}
+			size_t start = current;
+			current += length;
+			int rule = keyword_table.find(source.substr(start, length));
+			if (rule >= 0) {
+				if (wanted_rules[rule]) {
+					emit_token(start, input_tokens[rule].get_type(), DIAL_LEXER_VALUE::DIAL_NONE);
+				}
+			}
+			else if (has_identifier_rule && wanted_identifier) {
+				emit_token(start, identifier_type, DIAL_LEXER_VALUE::DIAL_IDENTIFIER);
+			}
+			return true;
+		}
+
+		//@reset_state reset @input_tokens, @current, @line state
+		//
+		void reset_state()
+		{
+			current = 0;
+			line = 1;
+			line_offset = 0;
+			stop_requested = false;
+			slice_paused = false;
+			has_error = false;
+		}
+
+		//@lex split @raw into @tokens based on the lexer type
+		//
+		//@raw source content to be splitted
+		//@options filter, limits and stop predicate for this split
+		//@tokens container the splitted tokens are written to, it is cut right after the last one
+		//@write_from position in @tokens the first splitted token is written to
+		//@start position to start splitting from
+		//@start_line line of the character at @start
+		//@end position no token may start from in this call, 0 means the end of @raw
+		//@kept number of tokens kept by earlier calls on the same content
+		void lex(std::string_view raw, const SplitOptions& options, vector<Token>& tokens, size_t write_from,
+			size_t start = 0, int64_t start_line = 1, size_t end = 0, size_t kept = 0)
+		{
+			compile();
+			reset_state();
+			this->output = &tokens;
+			this->output_start = this->output_count = write_from;
+			this->source = raw;
+			this->split_options = &options;
+			this->current = start;
+			this->line = start_line;
+			this->line_offset = start;
+			this->slice_start = start;
+			this->slice_end = end;
+			if constexpr (Policy::positions == DialPositionTracking::LINE_COLUMN) {
+				size_t newline = start > 0 ? raw.rfind('\n', start - 1) : std::string_view::npos;
+				this->line_begin = newline == std::string_view::npos ? 0 : newline + 1;
+			}
+			this->kept_before = kept;
+			try {
+				if (this->type == LexerType::RAW) {
+					raw_splitter();
+				}
+				else {
+					regex_splitter();
+				}
+			}
+			catch (...) {
+				finish_output();
+				throw;
+			}
+			finish_output();
+		}
+
+		//@finish_output cut @output right after the last splitted token and learn the bytes per token
+		//
+		void finish_output()
+		{
+			output->resize(output_count);
+			size_t count = output_count - output_start;
+			if (count > 0) {
+				double sample = static_cast<double>(current - slice_start) / count;
+				bytes_per_token = bytes_per_token > 0 ? (bytes_per_token * 3 + sample) / 4 : sample;
+			}
+		}
+
+		//@match_double_length length of the longest double value starting from current character
+		//accepts the same content as @validate_double without building it
+		//
+		size_t match_double_length() const {
+			size_t length = peek_lookahead(0) == '-' ? 1 : 0;
+			char c = peek_lookahead(length);
+			if (c != '.' && (c < '0' || c > '9')) {
+				return 0;
+			}
+			do {
+				c = peek_lookahead(++length);
+			} while (c == '.' || (c >= '0' && c <= '9'));
+			return length;
+		}
+
+		//@skip_string move past a string starting at the current character
+		//the end token is included when found, otherwise the string runs to the end of @source
+		//
+		//@start_lex starting string token
+		//@end_lex ending string token
+		void skip_string(std::string_view start_lex, std::string_view end_lex) {
+			current += start_lex.size();
+			while (!is_eof() && !match_word(end_lex)) {
+				++current;
+			}
+			current = std::min(current + end_lex.size(), get_eof());
+		}
+
+		//@emit_token append a token built from @source between @start and the current character
+		//
+		//@start position of the first character of the token
+		//@type user defined type of the token
+		//@value semantic value of the token
+		void emit_token(size_t start, TokenType type, DIAL_LEXER_VALUE value) {
+			push_token(type, this->source.substr(start, current - start), value);
+		}
+
+		//@line_at get the line of the character at @position
+		//the scanners never count lines, the newlines between the previous asked position and @position
+		//are found with memchr instead so positions asked in order cost a single pass over @source
+		//
+		//@position position of the character in @source
+		int64_t line_at(size_t position) {
+			const char* data = source.data();
+			if (position >= line_offset) {
+				const char* it = data + line_offset;
+				const char* end = data + position;
+				while (it < end && (it = static_cast<const char*>(std::memchr(it, '\n', end - it))) != nullptr) {
+					line++;
+					line_begin = ++it - data;
+				}
+			}
+			else {
+				line -= static_cast<int64_t>(std::count(data + position, data + line_offset, '\n'));
+				size_t newline = position > 0 ? source.rfind('\n', position - 1) : std::string_view::npos;
+				line_begin = newline == std::string_view::npos ? 0 : newline + 1;
+			}
+			line_offset = position;
+			return line;
+		}
+
+		//@report_error record a lexer error, nothing is recorded when the policy skips errors
+		//
+		//@error_token content no rule matched
+		//@position position of the first character of @error_token
+		void report_error(std::string_view error_token, size_t position) {
+			if constexpr (Policy::errors == DialErrorStrategy::THROW) {
 				has_error = true;
-				lex_exception.add_info(content, line, current, false);
+				error_sink->add_info(string(error_token), line_at(position), current, false);
+			}
+		}
+
+		//@push_token write a kept token to @output and check if lexing should stop
+		//a token left in @output by a previous split is overwritten in place to reuse its lexeme storage,
+		//the token ends at the current character and gets the line of its first character
+		//
+		//@type user defined type of the token
+		//@lexeme content of the token
+		//@value semantic value of the token
+		void push_token(TokenType type, std::string_view lexeme, DIAL_LEXER_VALUE value) {
+			if (output_count < output->size()) {
+				(*output)[output_count].assign(type, lexeme, value);
+			}
+			else {
+				output->emplace_back(type, string(lexeme), value);
+			}
+			Token& token = (*output)[output_count++];
+			size_t start = current - lexeme.size();
+			token.set_offset(start);
+			if constexpr (Policy::positions == DialPositionTracking::NONE) {
+				token.set_line(-1);
+			}
+			else {
+				token.set_line(line_at(start));
+			}
+			if constexpr (Policy::positions == DialPositionTracking::LINE_COLUMN) {
+				token.set_column(static_cast<int64_t>(start - line_begin) + 1);
+			}
+			size_t max_tokens = split_options->max_tokens;
+			if ((max_tokens > 0 && output_count - output_start + kept_before >= max_tokens) || (split_options->stop_when && split_options->stop_when(token))) {
+				stop_requested = true;
+			}
+		}
+
+		//@is_past_limit determine if the current character is at or after the byte limit of the split
+		//
+		bool is_past_limit() const {
+			size_t limit = byte_limit();
+			return limit > 0 && current >= limit;
+		}
+
+		//@byte_limit get the position no token may start from, 0 means no limit
+		//the closest of the split byte limit and the end of the current slice
+		//
+		size_t byte_limit() const {
+			size_t max_bytes = split_options->max_bytes;
+			return slice_end > 0 && (max_bytes == 0 || slice_end < max_bytes) ? slice_end : max_bytes;
+		}
+
+		//@should_stop determine if no further token may be matched in this split
+		//
+		bool should_stop() const {
+			return stop_requested || is_past_limit();
+		}
+
+		//@get_eof get @source size
+		//
+		size_t get_eof() const
+		{
+			return this->source.size();
+		}
+
+		//@is_eof determine if the current pointer is at end of file
+		//
+		bool const is_eof()
+		{
+			return current >= get_eof();
+		}
+
+		//@peek_lookahead look ahead to any given point from @source
+		//
+		char peek_lookahead(size_t offset) const
+		{
+			size_t position = current + offset;
+			return position < get_eof() ? this->source[position] : -1;
+		}
+
+		//@regex_splitter split @source content based on regex tokens
+		//
+		void regex_splitter()
+		{
+			index_filter();
+			wanted_rules.assign(input_tokens.size(), true);
+			for (size_t i = 0; i < input_tokens.size(); i++) {
+				wanted_rules[i] = is_wanted(input_tokens[i].get_type(), input_tokens[i].get_value());
+			}
+			if (active_regex_engine == DialRegexEngine::LAZY_DFA) {
+				lazy_dfa.begin_search();
+			}
+			size_t match_start = 0, match_length = 0, rule = string::npos;
+			//no match is searched past the byte limit so a slice of sparse content costs no more than its bytes
+			size_t limit = byte_limit();
+			size_t search_end = limit > 0 ? std::min(limit, source.size()) : source.size();
+			while (!stop_requested && find_regex_match(current, search_end, match_start, match_length, rule))
+			{
+				size_t split_pos = match_start - current;
+				std::string_view rem = source.substr(current, split_pos);
+				current = match_start + match_length;
+
+				if (rule == string::npos) {
+					report_error("can't match whitespaces", match_start);
+				}
+				if (Policy::errors == DialErrorStrategy::THROW && has_gap_content(rem)) {
+					report_error(rem, match_start - split_pos);
+				}
+				if (rule != string::npos && wanted_rules[rule]) {
+					push_token(input_tokens[rule].get_type(), source.substr(match_start, match_length), input_tokens[rule].get_value());
+				}
+			}
+			if (!stop_requested && search_end < source.size()) {
+				size_t max_bytes = split_options->max_bytes;
+				if (max_bytes > 0 && search_end >= max_bytes) {
+					stop_requested = true;
+				}
+				else {
+					//the content up to the end of the slice has no match start, the next slice resumes from there
+					if (current < search_end) {
+						std::string_view rem = source.substr(current, search_end - current);
+						if (Policy::errors == DialErrorStrategy::THROW && has_gap_content(rem)) {
+							report_error(rem, current);
+						}
+						current = search_end;
+					}
+					slice_paused = true;
+				}
+			}
+			if (!stop_requested && !slice_paused) {
+				std::string_view rem = source.substr(current);
+				if (Policy::errors == DialErrorStrategy::THROW && has_gap_content(rem)) {
+					report_error(rem, current);
+				}
+				current = get_eof();
 			}
 			if (has_error) {
-				throw lex_exception;
+				throw *error_sink;
 			}
-			return output_tokens;
 		}
 
-		//@raw_splitter split @source content based on raw hand crafted tokenizer
+		//@index_filter index the filter of the split by token type and semantic value
+		//token types are indexed when @DialTokenTraits gives their dense range, otherwise they are searched in the filter
 		//
-		vector<Token> raw_splitter()
+		void index_filter()
 		{
-			string exception_message = "";
-			vector<Token> vec = std::move(get_filtered_token(this->input_tokens, DIAL_LEXER_VALUE::DIAL_STRING_END));
-			Token end_token = !vec.empty() ? vec.at(0) : Token{};
+			const TokenFilter& filter = split_options->filter;
+			constexpr size_t type_count = DialTokenTraits<TokenType>::count;
+			filter_all = filter.types.empty() && filter.values.empty();
+			wanted_values.fill(false);
+			for (DIAL_LEXER_VALUE value : filter.values) {
+				if (static_cast<size_t>(value) < wanted_values.size()) {
+					wanted_values[static_cast<size_t>(value)] = true;
+				}
+			}
+			wanted_types.assign(type_count, false);
+			for (TokenType type : filter.types) {
+				if (static_cast<size_t>(type) < type_count) {
+					wanted_types[static_cast<size_t>(type)] = true;
+				}
+			}
+		}
 
-			bool status_good = verify_raw_tokens_integrity(input_tokens, exception_message, unknown_identifiers, comment_begin, comment_end);
-			if (!status_good) {
-				has_error = true;
-				throw DialLexerException(exception_message, line, current, true);
+		//@is_wanted determine if a token with @type and @value passes the filter indexed by @index_filter
+		//
+		bool is_wanted(TokenType type, DIAL_LEXER_VALUE value) const
+		{
+			if (filter_all || (static_cast<size_t>(value) < wanted_values.size() && wanted_values[static_cast<size_t>(value)])) {
+				return true;
+			}
+			if constexpr (DialTokenTraits<TokenType>::count > 0) {
+				return static_cast<size_t>(type) < wanted_types.size() && wanted_types[static_cast<size_t>(type)];
+			}
+			else {
+				return contains_ele(split_options->filter.types, type);
+			}
+		}
+
+		//@raw_splitter split @source content based on raw hand crafted tokenizer
+		//
+		void raw_splitter()
+		{
+			index_filter();
+			wanted_number = is_wanted(number_type, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE);
+			wanted_identifier = is_wanted(identifier_type, DIAL_LEXER_VALUE::DIAL_IDENTIFIER);
+			wanted_rules.assign(input_tokens.size(), true);
+			for (size_t i = 0; i < input_tokens.size(); i++) {
+				DIAL_LEXER_VALUE value = input_tokens[i].get_value();
+				wanted_rules[i] = is_wanted(input_tokens[i].get_type(), value == DIAL_LEXER_VALUE::DIAL_STRING_START ? DIAL_LEXER_VALUE::DIAL_STRING : value);
 			}
 
-			while (current < get_eof()) {
-				int previous_counter = current;
+			while (current < get_eof() && !stop_requested) {
+				size_t previous_counter = current;
 				switch (peek_lookahead(0)) {
 				case ' ': {
 					advance();
@@ -735,18 +5039,14 @@ namespace dial {
 					break;
 				}
 				case '\n': {
-					line++;
 					advance();
 				}
 						 break;
 				}
-				if (comment_begin != "") {
-					if (match_comment(true)) {
+				if constexpr (Policy::comments) {
+					if (comment_begin != "" && match_comment(true)) {
 						while (!is_eof() && !match_comment(false)) {
-							char c = advance();
-							if (c == '\n') {
-								line++;
-							}
+							advance();
 						}
 						//pull out of comment token
 						if (!is_eof()) {
@@ -756,14 +5056,40 @@ namespace dial {
 						}
 					}
 				}
-				for (vector<Token>::iterator token_iter = input_tokens.begin(); token_iter < input_tokens.end(); token_iter++) {
-					Token token = *token_iter;
-					string start_lex = token.get_lexeme();
+				if (is_past_limit()) {
+					break;
+				}
+				if (keyword_mode && match_keyword_or_identifier()) {
+					continue;
+				}
+				if (raw_engine == DialRawEngine::BYTECODE) {
+					for (size_t rule_index = next_candidate(0); rule_index < input_tokens.size() && run_rule(rule_index); rule_index = next_candidate(rule_index + 1)) {
+					}
+				}
+				//only the rules able to start at the current character are visited, in registration order
+				else for (size_t rule_index = next_candidate(0); rule_index < input_tokens.size(); rule_index = next_candidate(rule_index + 1)) {
+					Token& token = input_tokens[rule_index];
+					bool wanted = wanted_rules[rule_index];
+					const string& start_lex = token.get_lexeme();
 					size_t token_len = start_lex.size();
 					//match keywords
 					//handle string offset
 					bool is_string = static_cast<int>(token.get_value()) == static_cast<int>(DIAL_LEXER_VALUE::DIAL_STRING_START) ||
 						static_cast<int>(token.get_value()) == static_cast<int>(DIAL_LEXER_VALUE::DIAL_STRING_END);
+					//all DIAL_NONE literals are matched at once, the longest one wins
+					if (is_trie_literal(token)) {
+						size_t literal_length = 0;
+						int rule = rule_index == literal_group ? literal_trie.match(source.substr(current), literal_length) : -1;
+						if (rule < 0) {
+							continue;
+						}
+						Token& literal = input_tokens[rule];
+						current += literal_length;
+						if (wanted_rules[rule]) {
+							push_token(literal.get_type(), literal.get_lexeme(), DIAL_LEXER_VALUE::DIAL_NONE);
+						}
+						break;
+					}
 					if (!is_string) {
 						bool matched_all = token_len > 0 ? true : false;
 						for (size_t i = 0; i < token_len; i++) {
@@ -774,87 +5100,640 @@ namespace dial {
 							}
 						}
 						if (matched_all) {
-							for (size_t i = 0; i < token_len; i++) {
-								advance();
+							current += token_len;
+							if (wanted) {
+								push_token(token.get_type(), start_lex, token.get_value());
 							}
-							Token matched_token = token;
-							matched_token.set_line(line);
-							output_tokens.push_back(matched_token);
 							break;
 						}
 					}
 					switch (token.get_value()) {
 					case DIAL_LEXER_VALUE::DIAL_STRING_START: {
-						string word;
 						if (match_word(start_lex)) {
-							char c_f = advance();
-							word.push_back(c_f);
-							while (!is_eof() && !match_word(end_token.get_lexeme())) {
-								char c = peek();
-								if (c == '\n') {
-									line++;
-								}
-								word.push_back(c);
-								advance();
+							size_t start = current;
+							skip_string(start_lex, end_token.get_lexeme());
+							if (wanted) {
+								emit_token(start, token.get_type(), DIAL_LEXER_VALUE::DIAL_STRING);
 							}
-							//pull out of the last string token
-							advance();
-							Token token_ = Token(token.get_type(), start_lex + word, DIAL_LEXER_VALUE::DIAL_STRING);
-							token_.set_line(line);
-							output_tokens.push_back(token_);
 						}
 					}
+					[[fallthrough]];
 					case DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE: {
-						string double_content = match_get_double();
-						if (!double_content.empty()) {
-							std::for_each(double_content.begin(), double_content.end(), [&](char& ele) { advance(); });
-							Token token_ = Token(get_type(input_tokens, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE), double_content, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE);
-							token_.set_line(line);
-							output_tokens.push_back(token_);
+						if (should_stop()) {
+							break;
+						}
+						size_t double_length = match_double_length();
+						if (double_length > 0) {
+							size_t start = current;
+							current += double_length;
+							if (wanted_number) {
+								emit_token(start, number_type, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE);
+							}
 						}
 					}
+					[[fallthrough]];
 					case DIAL_LEXER_VALUE::DIAL_IDENTIFIER: {
-						string identifier = "", watcher = "";
-						match_identifiers(unknown_identifiers, identifier, watcher, true);
-						if (!identifier.empty()) {
-							Token token_ = Token(get_type(input_tokens, DIAL_LEXER_VALUE::DIAL_IDENTIFIER), identifier, DIAL_LEXER_VALUE::DIAL_IDENTIFIER);
-							token_.set_line(line);
-							output_tokens.push_back(token_);
-							identifier.clear();
+						if (should_stop()) {
+							break;
 						}
+						size_t start = current;
+						current += match_identifier_length();
+						if (current != start && wanted_identifier) {
+							emit_token(start, identifier_type, DIAL_LEXER_VALUE::DIAL_IDENTIFIER);
+						}
+					}
 					}
+					if (should_stop()) {
+						break;
 					}
 				}
 				if (previous_counter == current) {
 					//handle error
-					has_error = true;
+					has_error = Policy::errors == DialErrorStrategy::THROW;
 
 					//already at new line
 					if (match('\n')) {
-						exception_message.push_back('\n');
 						advance();
 						continue;
 					}
-					string error_token = { peek_lookahead(0) };
 					char a = ' ';
-					while (((a = advance()), a != '\n') && !is_eof()) {
-						error_token.push_back(a);
+					if constexpr (Policy::errors == DialErrorStrategy::THROW) {
+						size_t error_start = current;
+						string error_token = { peek_lookahead(0) };
+						while (((a = advance()), a != '\n') && !is_eof()) {
+							error_token.push_back(a);
+						}
+						error_sink->add_info(error_token, line_at(error_start), current, false);
+					}
+					else {
+						while (((a = advance()), a != '\n') && !is_eof()) {
+						}
 					}
-					lex_exception.add_info(error_token, line, current, false);
-					line++;//using new line or eof as breakpoint
+					//using new line or eof as breakpoint
 					advance();
 				}
 			}
 			if (has_error) {
-				throw lex_exception;
+				throw *error_sink;
 			}
-			return output_tokens;
 		}
 		vector<Token> input_tokens;
-		vector<Token> output_tokens;
+		vector<Token>* output = nullptr;
+		size_t output_start = 0, output_count = 0;
+		double bytes_per_token = 0;
 		vector<string> unknown_identifiers;
+
+		//@BatchWorkers copies of this lexer used by the workers of a batch, a copy of the lexer starts without them
+		struct BatchWorkers {
+			vector<std::unique_ptr<BasicDialLexer>> lexers;
+
+			BatchWorkers() = default;
+			BatchWorkers(const BatchWorkers&) {}
+			BatchWorkers(BatchWorkers&&) = default;
+			BatchWorkers& operator=(const BatchWorkers&) { lexers.clear(); return *this; }
+			BatchWorkers& operator=(BatchWorkers&&) = default;
+		};
+		BatchWorkers batch_workers;
+	};
+
+	using DialLexer = BasicDialLexer<TokenType>;
+#if defined(DIAL_LEXER_COROUTINES)
+	using DialTokenStream = BasicDialTokenStream<TokenType>;
+#endif
+
+	//@DialWorkerCache Copies of shared lexers owned by the calling thread
+	//
+	//a compiled lexer shared between threads is never split directly, each thread splits on its own copy
+	//a few copies are kept per thread so switching between lexers doesn't copy them on every split, the copy of a lexer
+	//no longer alive is dropped by the next lookup of the thread, the copies are not counted by @memory_usage
+	template <typename Lexer>
+	class DialWorkerCache {
+	public:
+		static constexpr size_t SLOTS = 8;
+
+		//@worker get the copy of @lexer owned by the calling thread, made when the thread first sees @lexer
+		//
+		//@lexer shared lexer, compiled
+		static Lexer& worker(const std::shared_ptr<const Lexer>& lexer)
+		{
+			thread_local Slot slots[SLOTS];
+			thread_local size_t next_slot = 0;
+			Slot* free_slot = nullptr;
+			for (Slot& slot : slots) {
+				if (slot.lexer && slot.source.expired()) {
+					slot.lexer.reset();
+					slot.source.reset();
+				}
+				//a weak pointer keeps its control block, so an expired lexer is never mistaken for a new one
+				if (slot.lexer && !slot.source.owner_before(lexer) && !lexer.owner_before(slot.source)) {
+					return *slot.lexer;
+				}
+				if (!slot.lexer && !free_slot) {
+					free_slot = &slot;
+				}
+			}
+			Slot& slot = free_slot ? *free_slot : slots[next_slot++ % SLOTS];
+			slot.lexer = std::make_unique<Lexer>(*lexer);
+			slot.source = lexer;
+			return *slot.lexer;
+		}
+
+	private:
+		//@Slot copy of one shared lexer, the shared lexer itself is not kept alive
+		struct Slot {
+			std::weak_ptr<const Lexer> source;
+			std::unique_ptr<Lexer> lexer;
+		};
+	};
+
+	//@BasicDialLexerHandle Shared handle to a compiled lexer replaced while it is in use
+	//
+	//readers check an atomic version number against the version their thread last took and only load the shared
+	//pointer again after a reload, so reads don't take the lock a shared pointer load may use, a split keeps the
+	//version it started with while later splits see the new one, each thread splits on its own copy of the version
+	//taken from @DialWorkerCache
+	template <typename TokenType, typename Policy = DialDefaultPolicy>
+	class BasicDialLexerHandle {
+	public:
+		using Lexer = BasicDialLexer<TokenType, Policy>;
+		using Token = BasicToken<TokenType>;
+		using SplitOptions = BasicSplitOptions<TokenType>;
+
+		//@BasicDialLexerHandle-constructor publish @lexer as the first version
+		//
+		//@lexer lexer to be used, validated here
+		explicit BasicDialLexerHandle(Lexer lexer)
+		{
+			reload(std::move(lexer));
+		}
+
+		BasicDialLexerHandle(const BasicDialLexerHandle&) = delete;
+		BasicDialLexerHandle& operator=(const BasicDialLexerHandle&) = delete;
+
+		//@reload compile @lexer and publish it as the current version, the current version is kept when it is invalid
+		//
+		//@lexer lexer replacing the current one
+		void reload(Lexer lexer)
+		{
+			lexer.compile();
+			//only writers are serialized so versions are published in order
+			std::lock_guard<std::mutex> lock(reload_mutex);
+			auto version = std::make_shared<const Version>(Version{ std::move(lexer), ++version_count });
+			uint64_t number = version->number;
+#if defined(__cpp_lib_atomic_shared_ptr)
+			current_version.store(std::move(version), std::memory_order_release);
+#else
+			std::atomic_store_explicit(&current_version, std::move(version), std::memory_order_release);
+#endif
+			published_number.store(number, std::memory_order_release);
+		}
+
+		//@current get the lexer currently published
+		//
+		std::shared_ptr<const Lexer> current() const
+		{
+			std::shared_ptr<const Version> version = load();
+			return std::shared_ptr<const Lexer>(version, &version->lexer);
+		}
+
+		//@version get the number of the current version, the first one is 1
+		//
+		uint64_t version() const
+		{
+			return load()->number;
+		}
+
+		//@split split @raw with the current version
+		//
+		//@raw source content to be splitted
+		//@options filter, limits and stop predicate for the content
+		vector<Token> split(std::string_view raw, const SplitOptions& options = SplitOptions()) const
+		{
+			Lexer& worker = DialWorkerCache<Lexer>::worker(current());
+			vector<Token> tokens;
+			SplitState state;
+			worker.split_slice(raw, state, raw.size() + 1, options, tokens);
+			if (state.has_error) {
+				throw state.errors;
+			}
+			return tokens;
+		}
+
+	private:
+		//@Version lexer published by one reload
+		struct Version {
+			Lexer lexer;
+			uint64_t number = 0;
+		};
+
+		//@Slot version of one handle last taken by the calling thread, kept alive until the slot is taken again
+		struct Slot {
+			uint64_t handle_id = 0;
+			std::shared_ptr<const Version> version;
+		};
+
+		static constexpr size_t SLOTS = 8;
+
+		//the shared pointer is only loaded when the thread has no version of this handle as recent as the published one
+		std::shared_ptr<const Version> load() const
+		{
+			thread_local Slot slots[SLOTS];
+			thread_local size_t next_slot = 0;
+			uint64_t number = published_number.load(std::memory_order_acquire);
+			for (Slot& slot : slots) {
+				if (slot.handle_id == handle_id) {
+					if (slot.version->number < number) {
+						slot.version = load_current();
+					}
+					return slot.version;
+				}
+			}
+			Slot& slot = slots[next_slot++ % SLOTS];
+			slot.handle_id = handle_id;
+			slot.version = load_current();
+			return slot.version;
+		}
+
+		std::shared_ptr<const Version> load_current() const
+		{
+#if defined(__cpp_lib_atomic_shared_ptr)
+			return current_version.load(std::memory_order_acquire);
+#else
+			return std::atomic_load_explicit(&current_version, std::memory_order_acquire);
+#endif
+		}
+
+		//handles are told apart by a number never reused, a new handle may get the address of a destroyed one
+		static uint64_t next_handle_id()
+		{
+			static std::atomic<uint64_t> count{ 0 };
+			return ++count;
+		}
+
+#if defined(__cpp_lib_atomic_shared_ptr)
+		std::atomic<std::shared_ptr<const Version>> current_version;
+#else
+		std::shared_ptr<const Version> current_version;
+#endif
+		uint64_t version_count = 0;
+		std::atomic<uint64_t> published_number{ 0 };
+		const uint64_t handle_id = next_handle_id();
+		std::mutex reload_mutex;
+	};
+
+	//@DialRegistryStats Activity of a lexer registry
+	//
+	struct DialRegistryStats {
+		size_t hits = 0;
+		size_t misses = 0;
+		size_t evictions = 0;
+		size_t entries = 0;
+		size_t memory_bytes = 0;
+		double compile_seconds = 0;
+		double max_compile_seconds = 0;
+
+		//@hit_rate get the share of lookups served by a compiled lexer
+		//
+		double hit_rate() const
+		{
+			return hits + misses == 0 ? 0 : static_cast<double>(hits) / static_cast<double>(hits + misses);
+		}
+	};
+
+	//@BasicDialLexerRegistry Cache of compiled lexers keyed by the hash of their spec
+	//
+	//lexers are compiled on the first lookup of their spec and shared by every thread, the least recently
+	//used ones are evicted once the estimated memory of the compiled lexers goes past the budget
+	//an evicted lexer stays alive while a caller still holds it, the per thread copies splits are made on
+	//are not counted in the budget, a thread drops the copy of an evicted lexer on its next split
+	template <typename TokenType, typename Policy = DialDefaultPolicy>
+	class BasicDialLexerRegistry {
+	public:
+		using Lexer = BasicDialLexer<TokenType, Policy>;
+		using Token = BasicToken<TokenType>;
+		using SplitOptions = BasicSplitOptions<TokenType>;
+
+		//@BasicDialLexerRegistry-constructor create an empty registry
+		//
+		//@types token type of each name used by the text specs
+		//@memory_budget bytes the compiled lexers may hold, the most recent lexer is kept even when larger
+		BasicDialLexerRegistry(std::unordered_map<string, TokenType> types, size_t memory_budget)
+			: types(std::move(types)), memory_budget(memory_budget)
+		{
+		}
+
+		BasicDialLexerRegistry(const BasicDialLexerRegistry&) = delete;
+		BasicDialLexerRegistry& operator=(const BasicDialLexerRegistry&) = delete;
+
+		//@get get the compiled lexer of the text spec @spec, compiled on a miss, throws when the spec is invalid
+		//
+		//@spec text spec, see @DialSpecParser
+		std::shared_ptr<const Lexer> get(std::string_view spec)
+		{
+			return get(spec, [&]() { return Lexer::from_spec(spec, types); });
+		}
+
+		//@get get the compiled lexer registered under @key, built by @build on a miss
+		//
+		//@key spec identifying the lexer, usually its text
+		//@build builds the lexer of @key, it is compiled by the registry
+		std::shared_ptr<const Lexer> get(std::string_view key, const std::function<Lexer()>& build)
+		{
+			size_t hash = std::hash<std::string_view>()(key);
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				auto found = index.find(hash);
+				if (found != index.end() && found->second->key == key) {
+					entries.splice(entries.begin(), entries, found->second);
+					registry_stats.hits++;
+					return found->second->lexer;
+				}
+				registry_stats.misses++;
+			}
+			//compiling outside the lock keeps lookups of other specs flowing
+			auto started = std::chrono::steady_clock::now();
+			auto lexer = std::make_shared<Lexer>(build());
+			lexer->compile();
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+			std::lock_guard<std::mutex> lock(mutex);
+			registry_stats.compile_seconds += seconds;
+			registry_stats.max_compile_seconds = std::max(registry_stats.max_compile_seconds, seconds);
+			auto found = index.find(hash);
+			if (found != index.end()) {
+				//another thread compiled the same spec meanwhile, or a colliding spec is replaced
+				if (found->second->key == key) {
+					entries.splice(entries.begin(), entries, found->second);
+					return found->second->lexer;
+				}
+				remove(found->second);
+			}
+			Entry entry;
+			entry.key = string(key);
+			entry.lexer = lexer;
+			entry.bytes = lexer->memory_usage() + entry.key.capacity();
+			entries.push_front(std::move(entry));
+			index[hash] = entries.begin();
+			registry_stats.memory_bytes += entries.front().bytes;
+			while (registry_stats.memory_bytes > memory_budget && entries.size() > 1) {
+				remove(std::prev(entries.end()));
+				registry_stats.evictions++;
+			}
+			return lexer;
+		}
+
+		//@split split @raw with the compiled lexer of the text spec @spec
+		//
+		//@spec text spec, see @DialSpecParser
+		//@raw source content to be splitted
+		//@options filter, limits and stop predicate for the content
+		vector<Token> split(std::string_view spec, std::string_view raw, const SplitOptions& options = SplitOptions())
+		{
+			Lexer& worker = DialWorkerCache<Lexer>::worker(get(spec));
+			vector<Token> tokens;
+			SplitState state;
+			worker.split_slice(raw, state, raw.size() + 1, options, tokens);
+			if (state.has_error) {
+				throw state.errors;
+			}
+			return tokens;
+		}
+
+		//@stats get the lookups, evictions and compile latency of the registry
+		//
+		DialRegistryStats stats() const
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			DialRegistryStats copy = registry_stats;
+			copy.entries = entries.size();
+			return copy;
+		}
+
+	private:
+		struct Entry {
+			string key;
+			std::shared_ptr<const Lexer> lexer;
+			size_t bytes = 0;
+		};
+
+		//@remove drop @entry from the registry, the lock is held
+		//
+		void remove(typename std::list<Entry>::iterator entry)
+		{
+			registry_stats.memory_bytes -= entry->bytes;
+			index.erase(std::hash<std::string_view>()(entry->key));
+			entries.erase(entry);
+		}
+
+		std::unordered_map<string, TokenType> types;
+		size_t memory_budget;
+		std::list<Entry> entries;
+		std::unordered_map<size_t, typename std::list<Entry>::iterator> index;
+		DialRegistryStats registry_stats;
+		mutable std::mutex mutex;
+	};
+
+	//@DialPriority Priority class of a scheduled document
+	//
+	//@INTERACTIVE -> latency sensitive requests, always served first
+	//@NORMAL -> regular requests
+	//@BACKGROUND -> bulk work only served when no other class is waiting
+	enum class DialPriority : int {
+		INTERACTIVE,
+		NORMAL,
+		BACKGROUND
+	};
+
+	//@DialSchedulerStats Timing of the documents of one priority class
+	//
+	//@completed number of documents finished
+	//@slices number of slices splitted
+	//@queue_seconds total time slices waited in the queue
+	//@max_queue_seconds longest time a single slice waited in the queue
+	//@lex_seconds total time spent splitting slices
+	struct DialSchedulerStats {
+		size_t completed = 0;
+		size_t slices = 0;
+		double queue_seconds = 0;
+		double max_queue_seconds = 0;
+		double lex_seconds = 0;
+	};
+
+	//@BasicDialScheduler Scheduler splitting documents of mixed priority over worker threads
+	//
+	//documents are splitted one slice at a time, an unfinished document goes back to the end of its lane
+	//so a large background document never holds a worker for more than one slice while a higher
+	//priority document is waiting
+	template <typename TokenType, typename Policy = DialDefaultPolicy>
+	class BasicDialScheduler {
+	public:
+		using Lexer = BasicDialLexer<TokenType, Policy>;
+		using Token = BasicToken<TokenType>;
+		using SplitOptions = BasicSplitOptions<TokenType>;
+
+		//@BasicDialScheduler-constructor start @worker_count workers, each with its own copy of @lexer
+		//
+		//@lexer lexer used to split every document, validated here
+		//@worker_count number of worker threads, at least one
+		//@slice_bytes number of bytes splitted before a worker picks its next document
+		BasicDialScheduler(const Lexer& lexer, size_t worker_count = std::thread::hardware_concurrency(), size_t slice_bytes = 1 << 16)
+			: slice_bytes(std::max<size_t>(slice_bytes, 1))
+		{
+			worker_count = std::max<size_t>(worker_count, 1);
+			lexers.assign(worker_count, lexer);
+			for (Lexer& worker_lexer : lexers) {
+				worker_lexer.compile();
+			}
+			for (size_t i = 0; i < worker_count; i++) {
+				threads.emplace_back([this, i]() { work(i); });
+			}
+		}
+
+		BasicDialScheduler(const BasicDialScheduler&) = delete;
+		BasicDialScheduler& operator=(const BasicDialScheduler&) = delete;
+
+		//@~BasicDialScheduler finish every submitted document then stop the workers
+		//
+		~BasicDialScheduler()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			wake.notify_all();
+			for (std::thread& thread : threads) {
+				thread.join();
+			}
+		}
+
+		//@submit queue @source to be splitted with @priority
+		//the future holds the tokens, or the lexer error of the document
+		//
+		//@source source content to be splitted, owned by the scheduler until it is done
+		//@priority priority class of the document
+		//@options filter, limits and stop predicate for the document
+		std::future<vector<Token>> submit(string source, DialPriority priority = DialPriority::NORMAL, SplitOptions options = SplitOptions())
+		{
+			auto job = std::make_unique<Job>();
+			job->source = std::move(source);
+			job->options = std::move(options);
+			job->priority = priority;
+			std::future<vector<Token>> result = job->promise.get_future();
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				job->queued_at = Clock::now();
+				lanes[static_cast<int>(priority)].push_back(std::move(job));
+			}
+			wake.notify_one();
+			return result;
+		}
+
+		//@stats get the timing of the documents of @priority
+		//
+		//@priority priority class
+		DialSchedulerStats stats(DialPriority priority) const
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return lane_stats[static_cast<int>(priority)];
+		}
+
+	private:
+		using Clock = std::chrono::steady_clock;
+		static constexpr int LANE_COUNT = 3;
+
+		struct Job {
+			string source;
+			SplitOptions options;
+			DialPriority priority = DialPriority::NORMAL;
+			SplitState state;
+			vector<Token> tokens;
+			std::promise<vector<Token>> promise;
+			Clock::time_point queued_at;
+		};
+
+		//@next_job take the oldest slice of the highest priority lane waiting
+		//
+		std::unique_ptr<Job> next_job()
+		{
+			for (auto& lane : lanes) {
+				if (!lane.empty()) {
+					std::unique_ptr<Job> job = std::move(lane.front());
+					lane.pop_front();
+					return job;
+				}
+			}
+			return nullptr;
+		}
+
+		//@work worker loop splitting one slice at a time
+		//
+		//@worker index of the worker
+		void work(size_t worker)
+		{
+			Lexer& lexer = lexers[worker];
+			while (true) {
+				std::unique_ptr<Job> job;
+				Clock::time_point started;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					wake.wait(lock, [this]() { return stopping || std::any_of(std::begin(lanes), std::end(lanes), [](auto& lane) { return !lane.empty(); }); });
+					job = next_job();
+					if (!job) {
+						return;
+					}
+					started = Clock::now();
+					DialSchedulerStats& stats = lane_stats[static_cast<int>(job->priority)];
+					double waited = std::chrono::duration<double>(started - job->queued_at).count();
+					stats.queue_seconds += waited;
+					stats.max_queue_seconds = std::max(stats.max_queue_seconds, waited);
+				}
+				bool finished = true;
+				std::exception_ptr failure;
+				try {
+					finished = lexer.split_slice(job->source, job->state, slice_bytes, job->options, job->tokens);
+				}
+				catch (...) {
+					failure = std::current_exception();
+				}
+				Clock::time_point ended = Clock::now();
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					DialSchedulerStats& stats = lane_stats[static_cast<int>(job->priority)];
+					stats.lex_seconds += std::chrono::duration<double>(ended - started).count();
+					stats.slices++;
+					if (!finished && !failure) {
+						job->queued_at = ended;
+						lanes[static_cast<int>(job->priority)].push_back(std::move(job));
+						wake.notify_one();
+						continue;
+					}
+					stats.completed++;
+				}
+				if (failure) {
+					job->promise.set_exception(failure);
+				}
+				else if (job->state.has_error) {
+					job->promise.set_exception(std::make_exception_ptr(job->state.errors));
+				}
+				else {
+					job->promise.set_value(std::move(job->tokens));
+				}
+			}
+		}
+
+		size_t slice_bytes;
+		vector<Lexer> lexers;
+		vector<std::thread> threads;
+		std::deque<std::unique_ptr<Job>> lanes[LANE_COUNT];
+		DialSchedulerStats lane_stats[LANE_COUNT];
+		mutable std::mutex mutex;
+		std::condition_variable wake;
+		bool stopping = false;
 	};
 
 	
+	using DialLexerHandle = BasicDialLexerHandle<TokenType>;
+	using DialLexerRegistry = BasicDialLexerRegistry<TokenType>;
+	using DialScheduler = BasicDialScheduler<TokenType>;
+
 }//end namespace dial
 #endif // end lexer lib
\ No newline at end of file
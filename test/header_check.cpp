@@ -0,0 +1,12 @@
+//the lexer header comes first so it has to bring every standard header it uses
+#include "../src/DialLexer.h"
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+TEST_CASE("Testing Header Builds On Its Own") {
+    dial::DialLineIndex index("a\nb");
+    CHECK(index.line_count() == 2);
+#if defined(DIAL_LEXER_COROUTINES)
+    CHECK(std::is_move_constructible_v<dial::DialTokenStream>);
+#endif
+}
@@ -1,6 +1,73 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest.h"
 #include "../src/DialLexer.h"
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <fstream>
+#include <cstdio>
+
+//counts every allocation made through the global operator new
+static std::atomic<size_t> allocation_count{ 0 };
+
+//kept out of line so the compiler never pairs an inlined malloc with a free of another overload
+#if defined(__GNUC__)
+#define DIAL_TEST_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define DIAL_TEST_NOINLINE __declspec(noinline)
+#else
+#define DIAL_TEST_NOINLINE
+#endif
+
+DIAL_TEST_NOINLINE void* operator new(std::size_t size) {
+    allocation_count++;
+    if (void* ptr = std::malloc(size > 0 ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+DIAL_TEST_NOINLINE void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+DIAL_TEST_NOINLINE void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+DIAL_TEST_NOINLINE void operator delete(void* ptr, std::size_t) noexcept {
+    ::operator delete(ptr);
+}
+
+DIAL_TEST_NOINLINE void operator delete[](void* ptr) noexcept {
+    ::operator delete(ptr);
+}
+
+DIAL_TEST_NOINLINE void operator delete[](void* ptr, std::size_t) noexcept {
+    ::operator delete(ptr);
+}
+
+//the nothrow forms are released by the deletes above, so they must allocate through the counting new too
+DIAL_TEST_NOINLINE void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return ::operator new(size);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+DIAL_TEST_NOINLINE void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return ::operator new(size, std::nothrow);
+}
+
+DIAL_TEST_NOINLINE void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    ::operator delete(ptr);
+}
+
+DIAL_TEST_NOINLINE void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    ::operator delete(ptr);
+}
 
 
 using namespace dial;
@@ -297,4 +364,1600 @@ TEST_CASE("Testing Regex Lexer") {
         }
         
     }
-}
\ No newline at end of file
+}
+TEST_CASE("Testing Token Filter") {
+    DialLexer dial_lexer;
+
+    //define syntax tokens
+    dial_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::WHILE, "while", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+    dial_lexer.add_token({ TokenType::STRING, "\"", DIAL_LEXER_VALUE::DIAL_STRING_START });
+    dial_lexer.add_token({ TokenType::STRING, "\"", DIAL_LEXER_VALUE::DIAL_STRING_END });
+    dial_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER + "|_", DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+
+    string sc = "if while 8.54 \n \"this is a string\" identifier_var";
+
+    SUBCASE("filter by token type") {
+        vector<Token> splitted_tokens = dial_lexer.split(sc, TokenFilter{ { TokenType::IDENTIFIER, TokenType::STRING }, {} });
+        REQUIRE(splitted_tokens.size() == 2);
+        CHECK(splitted_tokens.at(0).get_lexeme() == "\"this is a string\"");
+        CHECK(splitted_tokens.at(0).get_line() == 2);
+        CHECK(splitted_tokens.at(1).get_lexeme() == "identifier_var");
+    }
+
+    SUBCASE("filter by token value") {
+        vector<Token> splitted_tokens = dial_lexer.split(sc, TokenFilter{ {}, { DIAL_LEXER_VALUE::DIAL_NONE, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE } });
+        REQUIRE(splitted_tokens.size() == 3);
+        CHECK(splitted_tokens.at(0).get_lexeme() == "if");
+        CHECK(splitted_tokens.at(1).get_lexeme() == "while");
+        CHECK(splitted_tokens.at(2).get_lexeme() == "8.54");
+    }
+
+    SUBCASE("empty filter keeps every token") {
+        CHECK(dial_lexer.split(sc, TokenFilter()).size() == 5);
+    }
+}
+
+TEST_CASE("Testing Early Termination") {
+    DialLexer dial_lexer;
+
+    //define syntax tokens
+    dial_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::WHILE, "while", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+    dial_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER + "|_", DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+
+    //the invalid tail must never be reached
+    string sc = "if while 8.54 \n package_name if 42 ";
+    sc.append(1 << 20, ' ').append("& * @ !");
+
+    SUBCASE("max tokens") {
+        SplitOptions options;
+        options.max_tokens = 4;
+        vector<Token> splitted_tokens = dial_lexer.split(sc, options);
+        REQUIRE(splitted_tokens.size() == 4);
+        CHECK(splitted_tokens.at(3).get_lexeme() == "package_name");
+        CHECK(splitted_tokens.at(3).get_line() == 2);
+    }
+
+    SUBCASE("max tokens counts filtered tokens only") {
+        SplitOptions options;
+        options.filter.values = { DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE };
+        options.max_tokens = 2;
+        vector<Token> splitted_tokens = dial_lexer.split(sc, options);
+        REQUIRE(splitted_tokens.size() == 2);
+        CHECK(splitted_tokens.at(0).get_lexeme() == "8.54");
+        CHECK(splitted_tokens.at(1).get_lexeme() == "42");
+    }
+
+    SUBCASE("max bytes") {
+        SplitOptions options;
+        options.max_bytes = 10;
+        vector<Token> splitted_tokens = dial_lexer.split(sc, options);
+        REQUIRE(splitted_tokens.size() == 3);
+        CHECK(splitted_tokens.at(2).get_lexeme() == "8.54");
+    }
+
+    SUBCASE("stop predicate") {
+        SplitOptions options;
+        options.stop_when = [](const Token& token) { return token.get_value() == DIAL_LEXER_VALUE::DIAL_IDENTIFIER; };
+        vector<Token> splitted_tokens = dial_lexer.split(sc, options);
+        REQUIRE(splitted_tokens.size() == 4);
+        CHECK(splitted_tokens.back().get_lexeme() == "package_name");
+    }
+
+    SUBCASE("regex lexer") {
+        DialLexer regex_lexer{ LexerType::REGEX };
+        regex_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+        regex_lexer.add_token({ TokenType::NUMBER, "[0-9]+", DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+
+        string regex_sc = "if 12 if 42 ";
+        regex_sc.append(1 << 20, ' ').append("& * @ !");
+        SplitOptions options;
+        options.max_tokens = 3;
+        vector<Token> splitted_tokens = regex_lexer.split(regex_sc, options);
+        REQUIRE(splitted_tokens.size() == 3);
+        CHECK(splitted_tokens.at(2).get_lexeme() == "if");
+
+        options.max_tokens = 0;
+        options.max_bytes = 6;
+        CHECK(regex_lexer.split(regex_sc, options).size() == 2);
+    }
+}
+
+TEST_CASE("Testing Batch Lexer") {
+    DialLexer dial_lexer;
+
+    //define syntax tokens
+    dial_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::WHILE, "while", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+    dial_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER + "|_", DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+
+    vector<string> documents;
+    for (int i = 0; i < 500; i++) {
+        documents.push_back(i % 7 == 3 ? "if & " + std::to_string(i) : "while " + std::to_string(i) + " if name_" );
+    }
+    vector<std::string_view> inputs(documents.begin(), documents.end());
+    DialThreadPool pool(4);
+    vector<DialBatchResult> results = dial_lexer.split_batch(inputs, SplitOptions(), pool);
+
+    REQUIRE(results.size() == documents.size());
+    for (size_t i = 0; i < results.size(); i++) {
+        if (i % 7 == 3) {
+            CHECK(results.at(i).has_error);
+            CHECK(results.at(i).error == "Lexer Error :\n& " + std::to_string(i) + " at position " + std::to_string(documents.at(i).size()) + " at line 1");
+        }
+        else {
+            CHECK_FALSE(results.at(i).has_error);
+            REQUIRE(results.at(i).tokens.size() == 4);
+            CHECK(results.at(i).tokens.at(1).get_lexeme() == std::to_string(i));
+            CHECK(results.at(i).tokens.at(3).get_lexeme() == "name_");
+        }
+    }
+
+    SUBCASE("batch matches split") {
+        vector<DialBatchResult> shared_results = dial_lexer.split_batch({ "if 1", "while x" });
+        REQUIRE(shared_results.size() == 2);
+        CHECK(shared_results.at(0).tokens.size() == dial_lexer.split("if 1").size());
+        CHECK(shared_results.at(1).tokens.at(1).get_lexeme() == "x");
+    }
+
+    SUBCASE("batches into the same results reuse their storage") {
+        const Token* first_token = results.at(0).tokens.data();
+        dial_lexer.split_batch_into(inputs, results, SplitOptions(), pool);
+        REQUIRE(results.size() == documents.size());
+        CHECK(results.at(0).tokens.data() == first_token);
+        CHECK(results.at(3).has_error);
+        CHECK_FALSE(results.at(4).has_error);
+        CHECK(results.at(4).tokens.at(1).get_lexeme() == "4");
+        //the workers are copied again once the lexer changed
+        dial_lexer.add_token({ TokenType::ELSE, "&", DIAL_LEXER_VALUE::DIAL_NONE });
+        dial_lexer.split_batch_into(inputs, results, SplitOptions(), pool);
+        CHECK_FALSE(results.at(3).has_error);
+        CHECK(results.at(3).error.empty());
+        CHECK(results.at(3).tokens.size() == 3);
+    }
+}
+
+TEST_CASE("Testing Sliced Lexing And Scheduler") {
+    DialLexer dial_lexer;
+
+    //define syntax tokens
+    dial_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::WHILE, "while", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+    dial_lexer.add_token({ TokenType::STRING, "\"", DIAL_LEXER_VALUE::DIAL_STRING_START });
+    dial_lexer.add_token({ TokenType::STRING, "\"", DIAL_LEXER_VALUE::DIAL_STRING_END });
+    dial_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER + "|_", DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+
+    string sc;
+    for (int i = 0; i < 200; i++) {
+        sc.append("if while 8.54 \n \"this is a string\" identifier_var\n");
+    }
+    vector<Token> expected = dial_lexer.split(sc);
+
+    SUBCASE("slices resume where the previous one stopped") {
+        SplitState state;
+        vector<Token> splitted_tokens;
+        size_t slices = 0;
+        while (!dial_lexer.split_slice(sc, state, 7, SplitOptions(), splitted_tokens)) {
+            slices++;
+        }
+        CHECK(slices > 100);
+        CHECK_FALSE(state.has_error);
+        REQUIRE(splitted_tokens.size() == expected.size());
+        for (size_t i = 0; i < expected.size(); i++) {
+            CHECK(splitted_tokens.at(i) == expected.at(i));
+        }
+    }
+
+    SUBCASE("slices collect errors") {
+        SplitState state;
+        vector<Token> splitted_tokens;
+        while (!dial_lexer.split_slice("if & \n while", state, 2, SplitOptions(), splitted_tokens)) {
+        }
+        CHECK(state.has_error);
+        CHECK(string(state.errors.what()) == "Lexer Error :\n&  at position 5 at line 1");
+        CHECK(splitted_tokens.size() == 2);
+    }
+
+    SUBCASE("scheduler") {
+        DialScheduler scheduler(dial_lexer, 1, 64);
+        std::future<vector<Token>> background = scheduler.submit(sc, DialPriority::BACKGROUND);
+        std::future<vector<Token>> interactive = scheduler.submit("while 42", DialPriority::INTERACTIVE);
+        std::future<vector<Token>> invalid = scheduler.submit("while & 42", DialPriority::NORMAL);
+
+        vector<Token> interactive_tokens = interactive.get();
+        REQUIRE(interactive_tokens.size() == 2);
+        CHECK(interactive_tokens.at(1).get_lexeme() == "42");
+        CHECK(background.get().size() == expected.size());
+        CHECK_THROWS_AS(invalid.get(), DialLexerException);
+
+        CHECK(scheduler.stats(DialPriority::INTERACTIVE).completed == 1);
+        CHECK(scheduler.stats(DialPriority::INTERACTIVE).slices == 1);
+        CHECK(scheduler.stats(DialPriority::BACKGROUND).completed == 1);
+        CHECK(scheduler.stats(DialPriority::BACKGROUND).slices > 100);
+        CHECK(scheduler.stats(DialPriority::NORMAL).completed == 1);
+    }
+
+    SUBCASE("regex slices") {
+        DialLexer regex_lexer{ LexerType::REGEX };
+        regex_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+        regex_lexer.add_token({ TokenType::NUMBER, "[0-9]+", DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+        string regex_sc = "if 12 \n if 42 \n\n 7 if";
+        vector<Token> regex_expected = regex_lexer.split(regex_sc);
+
+        SplitState state;
+        vector<Token> splitted_tokens;
+        while (!regex_lexer.split_slice(regex_sc, state, 3, SplitOptions(), splitted_tokens)) {
+        }
+        REQUIRE(splitted_tokens.size() == regex_expected.size());
+        for (size_t i = 0; i < regex_expected.size(); i++) {
+            CHECK(splitted_tokens.at(i) == regex_expected.at(i));
+        }
+    }
+
+    SUBCASE("regex slices of sparse content stop at their end") {
+        string sparse_sc = "if" + string(5000, ' ') + "42\n" + string(3000, '\n') + "if";
+        for (DialRegexEngine engine : { DialRegexEngine::STD_REGEX, DialRegexEngine::DFA }) {
+            DialLexer regex_lexer{ LexerType::REGEX };
+            regex_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+            regex_lexer.add_token({ TokenType::NUMBER, "[0-9]+", DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+            regex_lexer.set_regex_engine(engine);
+            vector<Token> regex_expected = regex_lexer.split(sparse_sc);
+
+            SplitState state;
+            vector<Token> splitted_tokens;
+            CHECK_FALSE(regex_lexer.split_slice(sparse_sc, state, 100, SplitOptions(), splitted_tokens));
+            CHECK(state.position == 100);
+            CHECK(splitted_tokens.size() == 1);
+            size_t slices = 1;
+            while (!regex_lexer.split_slice(sparse_sc, state, 100, SplitOptions(), splitted_tokens)) {
+                CHECK(state.position <= 100 * (slices + 1));
+                slices++;
+            }
+            CHECK_FALSE(state.has_error);
+            CHECK(slices > 70);
+            REQUIRE(splitted_tokens.size() == regex_expected.size());
+            for (size_t i = 0; i < regex_expected.size(); i++) {
+                CHECK(splitted_tokens.at(i) == regex_expected.at(i));
+            }
+        }
+    }
+}
+
+TEST_CASE("Testing Split Into") {
+    DialLexer dial_lexer;
+
+    //define syntax tokens
+    dial_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+    dial_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER + "|_", DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+
+    string sc;
+    for (int i = 0; i < 100; i++) {
+        sc.append("if a_rather_long_identifier_name 42\n");
+    }
+    vector<Token> splitted_tokens;
+    dial_lexer.split_into(sc, splitted_tokens);
+    REQUIRE(splitted_tokens.size() == 300);
+
+    SUBCASE("capacity is reused") {
+        const Token* storage = splitted_tokens.data();
+        dial_lexer.split_into(sc, splitted_tokens);
+        CHECK(splitted_tokens.data() == storage);
+        REQUIRE(splitted_tokens.size() == 300);
+        CHECK(splitted_tokens.at(299).get_lexeme() == "42");
+        CHECK(splitted_tokens.at(299).get_line() == 100);
+    }
+
+    SUBCASE("previous tokens are overwritten") {
+        dial_lexer.split_into("x 1\nif", splitted_tokens);
+        REQUIRE(splitted_tokens.size() == 3);
+        CHECK(splitted_tokens.at(0).get_lexeme() == "x");
+        CHECK(splitted_tokens.at(0).get_value() == DIAL_LEXER_VALUE::DIAL_IDENTIFIER);
+        CHECK(splitted_tokens.at(1).get_lexeme() == "1");
+        CHECK(splitted_tokens.at(2).get_lexeme() == "if");
+        CHECK(splitted_tokens.at(2).get_line() == 2);
+    }
+
+    SUBCASE("empty output is pre-sized from previous splits") {
+        vector<Token> fresh_tokens;
+        dial_lexer.split_into(sc, fresh_tokens);
+        CHECK(fresh_tokens.size() == 300);
+        CHECK(fresh_tokens.capacity() <= 310);
+    }
+
+    SUBCASE("pre-sizing is bounded by the split limits") {
+        SplitOptions options;
+        options.max_tokens = 20;
+        vector<Token> limited_tokens;
+        dial_lexer.split_into(sc, limited_tokens, options);
+        CHECK(limited_tokens.size() == 20);
+        CHECK(limited_tokens.capacity() == 20);
+
+        options.max_tokens = 0;
+        options.max_bytes = 36;
+        vector<Token> prefix_tokens;
+        dial_lexer.split_into(sc, prefix_tokens, options);
+        CHECK(prefix_tokens.size() == 3);
+        CHECK(prefix_tokens.capacity() <= 10);
+    }
+}
+
+TEST_CASE("Testing Allocations Of A Frozen Lexer") {
+    DialLexer dial_lexer;
+
+    //define syntax tokens
+    dial_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::WHILE, "while", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+    dial_lexer.add_token({ TokenType::STRING, "\"", DIAL_LEXER_VALUE::DIAL_STRING_START });
+    dial_lexer.add_token({ TokenType::STRING, "\"", DIAL_LEXER_VALUE::DIAL_STRING_END });
+    dial_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER + "|_", DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+    dial_lexer.set_comment("#");
+    dial_lexer.compile();
+
+    string sc;
+    for (int i = 0; i < 1000; i++) {
+        sc.append("if while 8.54 # comment\n \"this is a rather long string\" a_rather_long_identifier_name\n");
+    }
+    vector<Token> splitted_tokens;
+    size_t warm_up = allocation_count;
+    dial_lexer.split_into(sc, splitted_tokens);
+    CHECK(allocation_count - warm_up > 0);
+    REQUIRE(splitted_tokens.size() == 5000);
+
+    size_t before = allocation_count;
+    dial_lexer.split_into(sc, splitted_tokens);
+    size_t allocations = allocation_count - before;
+
+    CHECK(allocations == 0);
+    REQUIRE(splitted_tokens.size() == 5000);
+    CHECK(splitted_tokens.at(4999).get_lexeme() == "a_rather_long_identifier_name");
+}
+
+TEST_CASE("Testing Identifier Scanner") {
+    DialLexer dial_lexer;
+
+    //define syntax tokens
+    dial_lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+    dial_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_UPPER + "|" + IS_IDENTIFIER_ALPHA_LOWER + "|_|::", DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+
+    SUBCASE("classes and fragments") {
+        vector<Token> splitted_tokens = dial_lexer.split("std::Vector_of 42 Name");
+        REQUIRE(splitted_tokens.size() == 3);
+        CHECK(splitted_tokens.at(0).get_lexeme() == "std::Vector_of");
+        CHECK(splitted_tokens.at(1).get_lexeme() == "42");
+        CHECK(splitted_tokens.at(2).get_lexeme() == "Name");
+    }
+
+    SUBCASE("long identifiers do not recurse") {
+        string identifier(1 << 22, 'a');
+        vector<Token> splitted_tokens = dial_lexer.split(identifier + " 1");
+        REQUIRE(splitted_tokens.size() == 2);
+        CHECK(splitted_tokens.at(0).get_lexeme().size() == identifier.size());
+    }
+
+    SUBCASE("non ascii bytes are not identifiers") {
+        CHECK_THROWS_AS(dial_lexer.split("abc \xC3\xA9"), DialLexerException);
+    }
+}
+
+TEST_CASE("Testing Keyword Mode") {
+    DialLexer dial_lexer;
+
+    //define syntax tokens
+    dial_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::ELSE, "else", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::WHILE, "while", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+    dial_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_NUM + "|_", DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+
+    SUBCASE("prefix literals are split by default") {
+        vector<Token> splitted_tokens = dial_lexer.split("iffy");
+        REQUIRE(splitted_tokens.size() == 2);
+        CHECK(splitted_tokens.at(0).get_type() == TokenType::IF);
+        CHECK(splitted_tokens.at(1).get_lexeme() == "fy");
+    }
+
+    SUBCASE("whole identifiers are classified") {
+        dial_lexer.set_keyword_mode(true);
+        vector<Token> splitted_tokens = dial_lexer.split("iffy if else_ while 12 elsewhere");
+        REQUIRE(splitted_tokens.size() == 6);
+        CHECK(splitted_tokens.at(0).get_type() == TokenType::IDENTIFIER);
+        CHECK(splitted_tokens.at(0).get_lexeme() == "iffy");
+        CHECK(splitted_tokens.at(1).get_type() == TokenType::IF);
+        CHECK(splitted_tokens.at(2).get_lexeme() == "else_");
+        CHECK(splitted_tokens.at(3).get_type() == TokenType::WHILE);
+        CHECK(splitted_tokens.at(4).get_type() == TokenType::NUMBER);
+        CHECK(splitted_tokens.at(5).get_type() == TokenType::IDENTIFIER);
+    }
+
+    SUBCASE("filters apply to keywords") {
+        dial_lexer.set_keyword_mode(true);
+        TokenFilter filter;
+        filter.types = { TokenType::WHILE };
+        vector<Token> splitted_tokens = dial_lexer.split("if x while y", filter);
+        REQUIRE(splitted_tokens.size() == 1);
+        CHECK(splitted_tokens.at(0).get_type() == TokenType::WHILE);
+    }
+
+    SUBCASE("many keywords") {
+        DialLexer keyword_lexer;
+        vector<string> words;
+        for (int i = 0; i < 300; i++) {
+            words.push_back("kw" + std::to_string(i * 7919));
+            keyword_lexer.add_token({ TokenType::WHILE, words.back(), DIAL_LEXER_VALUE::DIAL_NONE });
+        }
+        keyword_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_NUM, DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+        keyword_lexer.set_keyword_mode(true);
+        string source;
+        for (const string& word : words) {
+            source += word + " " + word + "x ";
+        }
+        vector<Token> splitted_tokens = keyword_lexer.split(source);
+        REQUIRE(splitted_tokens.size() == words.size() * 2);
+        for (size_t i = 0; i < words.size(); i++) {
+            CHECK(splitted_tokens.at(i * 2).get_type() == TokenType::WHILE);
+            CHECK(splitted_tokens.at(i * 2 + 1).get_type() == TokenType::IDENTIFIER);
+        }
+    }
+}
+
+TEST_CASE("Testing Longest Literal Match") {
+    DialLexer dial_lexer;
+
+    //define syntax tokens, shorter operators first
+    dial_lexer.add_token({ TokenType::ELSE, "=", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::ELSE, "==", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::WHILE, ">", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::ELSE, "===", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::WHILE, ">>=", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::WHILE, ">>", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+    dial_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER, DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+
+    SUBCASE("longest operator wins") {
+        vector<Token> splitted_tokens = dial_lexer.split("a === b >>= c == d = e >> f > 1");
+        vector<string> lexemes;
+        for (const Token& token : splitted_tokens) {
+            lexemes.push_back(token.get_lexeme());
+        }
+        CHECK(lexemes == vector<string>{ "a", "===", "b", ">>=", "c", "==", "d", "=", "e", ">>", "f", ">", "1" });
+    }
+
+    SUBCASE("adjacent operators") {
+        vector<Token> splitted_tokens = dial_lexer.split("=====>>>=");
+        vector<string> lexemes;
+        for (const Token& token : splitted_tokens) {
+            lexemes.push_back(token.get_lexeme());
+        }
+        CHECK(lexemes == vector<string>{ "===", "==", ">>", ">", "=" });
+    }
+}
+
+TEST_CASE("Testing First Byte Dispatch") {
+    DialLexer dial_lexer;
+
+    //define syntax tokens
+    dial_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+    dial_lexer.add_token({ TokenType::STRING, "'", DIAL_LEXER_VALUE::DIAL_STRING_START });
+    dial_lexer.add_token({ TokenType::STRING, "'", DIAL_LEXER_VALUE::DIAL_STRING_END });
+    dial_lexer.add_token({ TokenType::ELSE, "+", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER, DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+
+    SUBCASE("rules after a match see the next character") {
+        vector<Token> splitted_tokens = dial_lexer.split("8.5abc+'str'x if");
+        vector<string> lexemes;
+        for (const Token& token : splitted_tokens) {
+            lexemes.push_back(token.get_lexeme());
+        }
+        CHECK(lexemes == vector<string>{ "8.5", "abc", "+", "'str'", "x", "if" });
+    }
+
+    SUBCASE("bytes no rule starts with are errors") {
+        CHECK_THROWS_AS(dial_lexer.split("if @ x"), DialLexerException);
+        CHECK_THROWS_AS(dial_lexer.split("ABC"), DialLexerException);
+    }
+}
+
+TEST_CASE("Testing Lazy DFA Regex Engine") {
+    vector<string> patterns = { "if", "while", "[0-9]+", "[a-z_][a-z0-9_]*", "\"[^\"]*\"", "[-+*/=<>]=?", "0x[0-9a-f]+", "(ab|a)(c|bcd)", "x{2,3}y?" };
+    auto make_lexer = [&](DialRegexEngine engine, size_t cache_bytes) {
+        DialLexer dial_lexer{ LexerType::REGEX };
+        for (size_t i = 0; i < patterns.size(); i++) {
+            dial_lexer.add_token({ static_cast<TokenType>(i % 6), patterns[i], DIAL_LEXER_VALUE::DIAL_NONE });
+        }
+        dial_lexer.set_regex_engine(engine, cache_bytes);
+        return dial_lexer;
+    };
+    DialLexer std_lexer = make_lexer(DialRegexEngine::STD_REGEX, 0);
+    DialLexer dfa_lexer = make_lexer(DialRegexEngine::DFA, DialLazyDfa::DEFAULT_CACHE_BYTES);
+    DialLexer small_lexer = make_lexer(DialRegexEngine::LAZY_DFA, 1);
+
+    SUBCASE("engines are chosen") {
+        CHECK(std_lexer.regex_stats().engine == DialRegexEngine::STD_REGEX);
+        CHECK(dfa_lexer.regex_stats().engine == DialRegexEngine::DFA);
+        DialLexer anchored{ LexerType::REGEX };
+        anchored.add_token({ TokenType::IF, "^if", DIAL_LEXER_VALUE::DIAL_NONE });
+        anchored.set_regex_engine(DialRegexEngine::LAZY_DFA);
+        CHECK(anchored.regex_stats().engine == DialRegexEngine::STD_REGEX);
+        CHECK(anchored.split("if").size() == 1);
+    }
+
+    SUBCASE("same tokens as std::regex") {
+        const string alphabet = "ifwhle0123x_abcd\"+=<- \n";
+        unsigned seed = 7;
+        for (int round = 0; round < 300; round++) {
+            string source;
+            for (int i = 0; i < 40; i++) {
+                seed = seed * 1103515245 + 12345;
+                source.push_back(alphabet[(seed >> 16) % alphabet.size()]);
+            }
+            vector<Token> expected, dfa_tokens, small_tokens;
+            bool expected_error = false, dfa_error = false, small_error = false;
+            try { expected = std_lexer.split(source); } catch (const DialLexerException&) { expected_error = true; }
+            try { dfa_tokens = dfa_lexer.split(source); } catch (const DialLexerException&) { dfa_error = true; }
+            try { small_tokens = small_lexer.split(source); } catch (const DialLexerException&) { small_error = true; }
+            CHECK(expected_error == dfa_error);
+            CHECK(expected_error == small_error);
+            if (!expected_error) {
+                CHECK(expected == dfa_tokens);
+                CHECK(expected == small_tokens);
+            }
+        }
+    }
+
+    SUBCASE("rules after grouped patterns keep their types") {
+        DialLexer anchored{ LexerType::REGEX };
+        anchored.add_token({ TokenType::IF, "^(a)(b)", DIAL_LEXER_VALUE::DIAL_NONE });
+        anchored.add_token({ TokenType::ELSE, "c", DIAL_LEXER_VALUE::DIAL_NONE });
+        vector<Token> anchored_tokens = anchored.split("abc");
+        REQUIRE(anchored_tokens.size() == 2);
+        CHECK(anchored_tokens[0].get_type() == TokenType::IF);
+        CHECK(anchored_tokens[0].get_lexeme() == "ab");
+        CHECK(anchored_tokens[1].get_type() == TokenType::ELSE);
+
+        auto make_grouped_lexer = [](DialRegexEngine engine) {
+            DialLexer dial_lexer{ LexerType::REGEX };
+            dial_lexer.add_token({ TokenType::IF, "(ab|a)(c|bcd)", DIAL_LEXER_VALUE::DIAL_NONE });
+            dial_lexer.add_token({ TokenType::WHILE, "x{2,3}(y)?", DIAL_LEXER_VALUE::DIAL_NONE });
+            dial_lexer.add_token({ TokenType::NUMBER, "[0-9]+", DIAL_LEXER_VALUE::DIAL_NONE });
+            dial_lexer.set_regex_engine(engine);
+            return dial_lexer;
+        };
+        DialLexer grouped_lexer = make_grouped_lexer(DialRegexEngine::STD_REGEX);
+        DialLexer grouped_dfa_lexer = make_grouped_lexer(DialRegexEngine::DFA);
+        REQUIRE(grouped_lexer.regex_stats().engine == DialRegexEngine::STD_REGEX);
+        vector<Token> grouped_tokens = grouped_lexer.split("abcd xxy 12 ac xx");
+        REQUIRE(grouped_tokens.size() == 5);
+        CHECK(grouped_tokens[0].get_type() == TokenType::IF);
+        CHECK(grouped_tokens[1].get_type() == TokenType::WHILE);
+        CHECK(grouped_tokens[2].get_type() == TokenType::NUMBER);
+        CHECK(grouped_tokens[3].get_type() == TokenType::IF);
+        CHECK(grouped_tokens[4].get_type() == TokenType::WHILE);
+        CHECK(grouped_tokens == grouped_dfa_lexer.split("abcd xxy 12 ac xx"));
+    }
+
+    SUBCASE("small cache stays bounded") {
+        auto make_blowup_lexer = [](DialRegexEngine engine, size_t cache_bytes) {
+            DialLexer dial_lexer{ LexerType::REGEX };
+            dial_lexer.add_token({ TokenType::IF, "[ab]*a[ab]{8}", DIAL_LEXER_VALUE::DIAL_NONE });
+            dial_lexer.add_token({ TokenType::ELSE, "[ab]+", DIAL_LEXER_VALUE::DIAL_NONE });
+            dial_lexer.set_regex_engine(engine, cache_bytes);
+            return dial_lexer;
+        };
+        DialLexer expected_lexer = make_blowup_lexer(DialRegexEngine::STD_REGEX, 0);
+        DialLexer bounded_lexer = make_blowup_lexer(DialRegexEngine::LAZY_DFA, 1);
+        string source;
+        unsigned seed = 11;
+        for (int word = 0; word < 200; word++) {
+            for (int i = 0; i < 30; i++) {
+                seed = seed * 1103515245 + 12345;
+                source.push_back((seed >> 16) % 2 ? 'a' : 'b');
+            }
+            source.push_back(' ');
+        }
+        CHECK(bounded_lexer.split(source) == expected_lexer.split(source));
+        DialRegexStats stats = bounded_lexer.regex_stats();
+        CHECK(stats.cache_resets > 0);
+        CHECK(stats.cache_bytes <= 16 * (256 * sizeof(int) + 96) + 3 * sizeof(int) * stats.nfa_states * 16);
+    }
+    SUBCASE("whitespace matches are errors on every engine") {
+        for (DialRegexEngine engine : { DialRegexEngine::AUTO, DialRegexEngine::STD_REGEX, DialRegexEngine::LAZY_DFA, DialRegexEngine::DFA }) {
+            DialLexer dial_lexer{ LexerType::REGEX };
+            dial_lexer.add_token({ TokenType::IDENTIFIER, "[^ ]+", DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+            dial_lexer.set_regex_engine(engine);
+            CHECK_THROWS_AS(dial_lexer.split("b \n"), DialLexerException);
+            CHECK(dial_lexer.split("b c\td").size() == 2);
+        }
+    }
+}
+
+TEST_CASE("Testing Minimized DFA Tables") {
+    auto make_lexer = [](const vector<string>& patterns, DialRegexEngine engine) {
+        DialLexer dial_lexer{ LexerType::REGEX };
+        for (size_t i = 0; i < patterns.size(); i++) {
+            dial_lexer.add_token({ static_cast<TokenType>(i % 6), patterns[i], DIAL_LEXER_VALUE::DIAL_NONE });
+        }
+        dial_lexer.set_regex_engine(engine);
+        return dial_lexer;
+    };
+    vector<string> patterns = { "if", "while", "[0-9]+", "[a-z_][a-z0-9_]*", "\"[^\"]*\"", "[-+*/=<>]=?", "0x[0-9a-f]+" };
+
+    SUBCASE("table footprint") {
+        vector<string> redundant_patterns = patterns;
+        redundant_patterns.push_back("(ab|a)(c|bcd)");
+        redundant_patterns.push_back("x{2,3}y?");
+        DialLexer dial_lexer = make_lexer(redundant_patterns, DialRegexEngine::DFA);
+        DialRegexStats stats = dial_lexer.regex_stats();
+        REQUIRE(stats.engine == DialRegexEngine::DFA);
+        CHECK(stats.byte_classes < 32);
+        CHECK(stats.dfa_states < stats.unminimized_states);
+        CHECK(stats.table_bytes == stats.dfa_states * stats.byte_classes + 256);
+    }
+
+    SUBCASE("same tokens as the lazy DFA") {
+        DialLexer dfa_lexer = make_lexer(patterns, DialRegexEngine::DFA);
+        DialLexer lazy_lexer = make_lexer(patterns, DialRegexEngine::LAZY_DFA);
+        string source = "if while whiles 0x1f 0x 12 \"a b\" <= = -- ifx if_0 \n";
+        for (int i = 0; i < 5; i++) {
+            source += source;
+        }
+        vector<Token> dfa_tokens = dfa_lexer.split(source);
+        CHECK(dfa_tokens == lazy_lexer.split(source));
+        CHECK(dfa_tokens.size() == 32 * 14);
+    }
+
+    SUBCASE("large automata stay lazy") {
+        DialLexer dial_lexer = make_lexer({ "[ab]*a[ab]{70}" }, DialRegexEngine::AUTO);
+        CHECK(dial_lexer.regex_stats().engine == DialRegexEngine::LAZY_DFA);
+    }
+}
+
+TEST_CASE("Testing Hybrid Regex Engine") {
+    auto make_lexer = [](const vector<string>& patterns, DialRegexEngine engine) {
+        DialLexer dial_lexer{ LexerType::REGEX };
+        for (size_t i = 0; i < patterns.size(); i++) {
+            dial_lexer.add_token({ static_cast<TokenType>(i % 6), patterns[i], DIAL_LEXER_VALUE::DIAL_NONE });
+        }
+        dial_lexer.set_regex_engine(engine);
+        return dial_lexer;
+    };
+
+    SUBCASE("rules are routed by shape") {
+        DialLexer dial_lexer = make_lexer({ "if", "\\+\\+", "[0-9]+", "[a-z_][a-z0-9_]*", "[-+*/]", "0x[0-9a-f]+" }, DialRegexEngine::HYBRID);
+        DialRegexStats stats = dial_lexer.regex_stats();
+        REQUIRE(stats.engine == DialRegexEngine::HYBRID);
+        CHECK(stats.literal_rules == 2);
+        CHECK(stats.class_rules == 3);
+        CHECK(stats.complex_rules == 1);
+        CHECK(make_lexer({ "if", "[0-9]+" }, DialRegexEngine::AUTO).regex_stats().engine == DialRegexEngine::HYBRID);
+        CHECK(make_lexer({ "if", "0x[0-9]+" }, DialRegexEngine::AUTO).regex_stats().engine == DialRegexEngine::SHIFT_OR);
+        CHECK(make_lexer({ "if", "0x[0-9]{64}" }, DialRegexEngine::AUTO).regex_stats().engine == DialRegexEngine::DFA);
+    }
+
+    SUBCASE("same tokens as std::regex") {
+        vector<string> patterns = { "if", "while", "[0-9]+", "[a-z_][a-z0-9_]*", "\"[^\"]*\"", "[-+*/=<>]=?", "0x[0-9a-f]+", "\\+\\+", "[=]", "(xy)+" };
+        DialLexer std_lexer = make_lexer(patterns, DialRegexEngine::STD_REGEX);
+        DialLexer hybrid_lexer = make_lexer(patterns, DialRegexEngine::HYBRID);
+        const string alphabet = "ifwhle0123xy_abcd\"+=<- \n";
+        unsigned seed = 3;
+        for (int round = 0; round < 300; round++) {
+            string source;
+            for (int i = 0; i < 40; i++) {
+                seed = seed * 1103515245 + 12345;
+                source.push_back(alphabet[(seed >> 16) % alphabet.size()]);
+            }
+            vector<Token> expected, hybrid_tokens;
+            bool expected_error = false, hybrid_error = false;
+            try { expected = std_lexer.split(source); } catch (const DialLexerException&) { expected_error = true; }
+            try { hybrid_tokens = hybrid_lexer.split(source); } catch (const DialLexerException&) { hybrid_error = true; }
+            CHECK(expected_error == hybrid_error);
+            CHECK(expected == hybrid_tokens);
+        }
+    }
+}
+
+TEST_CASE("Testing Regex Prefilter") {
+    SUBCASE("candidates match a plain scan") {
+        unsigned seed = 5;
+        auto next = [&]() { seed = seed * 1103515245 + 12345; return (seed >> 16) & 0xff; };
+        for (int round = 0; round < 50; round++) {
+            DialByteSet first_bytes;
+            int set_size = round < 25 ? 1 + round % 6 : 20 + round * 3;
+            for (int i = 0; i < set_size; i++) {
+                first_bytes.add(static_cast<unsigned char>(next()));
+            }
+            DialBytePrefilter prefilter;
+            prefilter.build(first_bytes);
+            vector<unsigned char> data(300);
+            for (unsigned char& c : data) {
+                c = static_cast<unsigned char>(next());
+            }
+            for (size_t start = 0; start < data.size(); start += 7) {
+                size_t expected = start;
+                while (expected < data.size() && !first_bytes.contains(data[expected])) {
+                    expected++;
+                }
+                CHECK(start + prefilter.find(data.data() + start, data.size() - start) == expected);
+            }
+        }
+    }
+
+    SUBCASE("whitespace gaps") {
+        string gap(100, ' ');
+        gap[37] = '\n';
+        gap[60] = '\t';
+        CHECK(DialBytePrefilter::find_content(reinterpret_cast<const unsigned char*>(gap.data()), gap.size()) == gap.size());
+        gap[81] = '#';
+        CHECK(DialBytePrefilter::find_content(reinterpret_cast<const unsigned char*>(gap.data()), gap.size()) == 81);
+    }
+
+    SUBCASE("sparse tokens in large text") {
+        DialLexer dial_lexer{ LexerType::REGEX };
+        dial_lexer.add_token({ TokenType::NUMBER, "[0-9]+", DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+        dial_lexer.add_token({ TokenType::IF, "0x[0-9a-f]+", DIAL_LEXER_VALUE::DIAL_NONE });
+        string source;
+        for (int i = 0; i < 1000; i++) {
+            source += string(97, i % 3 ? ' ' : '\n') + std::to_string(i);
+        }
+        vector<Token> splitted_tokens = dial_lexer.split(source);
+        REQUIRE(splitted_tokens.size() == 1000);
+        CHECK(splitted_tokens.at(999).get_lexeme() == "999");
+        CHECK(splitted_tokens.at(999).get_line() == 1 + 334 * 97);
+    }
+}
+
+TEST_CASE("Testing Shift-Or Regex Engine") {
+    auto make_lexer = [](const vector<string>& patterns, DialRegexEngine engine) {
+        DialLexer dial_lexer{ LexerType::REGEX };
+        for (size_t i = 0; i < patterns.size(); i++) {
+            dial_lexer.add_token({ static_cast<TokenType>(i % 6), patterns[i], DIAL_LEXER_VALUE::DIAL_NONE });
+        }
+        dial_lexer.set_regex_engine(engine);
+        return dial_lexer;
+    };
+    vector<string> patterns = { "if", "while", "[0-9]+", "[a-z_][a-z0-9_]*", "\"[^\"]*\"", "[-+*/=<>]=?", "0x[0-9a-f]+", "(ab|a)(c|bcd)", "x{2,3}y?", "(xy)+z?" };
+
+    SUBCASE("small rule sets are chosen automatically") {
+        DialRegexStats stats = make_lexer(patterns, DialRegexEngine::AUTO).regex_stats();
+        CHECK(stats.engine == DialRegexEngine::SHIFT_OR);
+        CHECK(stats.nfa_states <= 64);
+        CHECK(make_lexer({ "[a-z]{65}" }, DialRegexEngine::SHIFT_OR).regex_stats().engine == DialRegexEngine::DFA);
+    }
+
+    SUBCASE("same tokens as std::regex") {
+        DialLexer std_lexer = make_lexer(patterns, DialRegexEngine::STD_REGEX);
+        DialLexer shift_or_lexer = make_lexer(patterns, DialRegexEngine::SHIFT_OR);
+        const string alphabet = "ifwhle0123xyz_abcd\"+=<- \n";
+        unsigned seed = 17;
+        for (int round = 0; round < 300; round++) {
+            string source;
+            for (int i = 0; i < 40; i++) {
+                seed = seed * 1103515245 + 12345;
+                source.push_back(alphabet[(seed >> 16) % alphabet.size()]);
+            }
+            vector<Token> expected, shift_or_tokens;
+            bool expected_error = false, shift_or_error = false;
+            try { expected = std_lexer.split(source); } catch (const DialLexerException&) { expected_error = true; }
+            try { shift_or_tokens = shift_or_lexer.split(source); } catch (const DialLexerException&) { shift_or_error = true; }
+            CHECK(expected_error == shift_or_error);
+            CHECK(expected == shift_or_tokens);
+        }
+    }
+}
+
+TEST_CASE("Testing Bytecode Program") {
+    DialLexer dial_lexer;
+
+    //define syntax tokens
+    dial_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::ELSE, "else", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::WHILE, "while", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+    dial_lexer.add_token({ TokenType::STRING, "\"", DIAL_LEXER_VALUE::DIAL_STRING_START });
+    dial_lexer.add_token({ TokenType::STRING, "\"", DIAL_LEXER_VALUE::DIAL_STRING_END });
+    dial_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER, DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+    dial_lexer.set_comment("#");
+
+    const string sc = "if x1 \"a string\" else 42.5 #comment while\nwhile 7 y \"\" elsewhere -3";
+    vector<Token> expected = dial_lexer.split(sc);
+
+    auto same_tokens = [](const vector<Token>& left, const vector<Token>& right) {
+        REQUIRE(left.size() == right.size());
+        for (size_t i = 0; i < left.size(); i++) {
+            CHECK(left[i].get_type() == right[i].get_type());
+            CHECK(left[i].get_lexeme() == right[i].get_lexeme());
+            CHECK(left[i].get_line() == right[i].get_line());
+        }
+    };
+
+    SUBCASE("the virtual machine splits like the rule loop") {
+        dial_lexer.set_raw_engine(DialRawEngine::BYTECODE);
+        same_tokens(dial_lexer.split(sc), expected);
+    }
+
+    SUBCASE("a serialized program loads into an empty lexer") {
+        string blob = dial_lexer.program().serialize();
+        DialLexer loaded_lexer;
+        loaded_lexer.load_program(DialProgram::deserialize(blob));
+        same_tokens(loaded_lexer.split(sc), expected);
+        CHECK_THROWS_AS(loaded_lexer.split("if @"), DialLexerException);
+    }
+
+    SUBCASE("corrupted programs are rejected") {
+        string blob = dial_lexer.program().serialize();
+        CHECK_THROWS_AS(DialProgram::deserialize(blob.substr(0, blob.size() / 2)), DialLexerException);
+        blob[0] ^= 0x55;
+        CHECK_THROWS_AS(DialProgram::deserialize(blob), DialLexerException);
+    }
+}
+
+TEST_CASE("Testing Lexer Images") {
+    auto lexemes_of = [](const vector<Token>& tokens) {
+        vector<string> lexemes;
+        for (const Token& token : tokens) {
+            lexemes.push_back(token.get_lexeme());
+        }
+        return lexemes;
+    };
+
+    SUBCASE("raw lexers reload their program") {
+        DialLexer dial_lexer;
+        dial_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+        dial_lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+        dial_lexer.add_token({ TokenType::STRING, "'", DIAL_LEXER_VALUE::DIAL_STRING_START });
+        dial_lexer.add_token({ TokenType::STRING, "'", DIAL_LEXER_VALUE::DIAL_STRING_END });
+        dial_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER, DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+        dial_lexer.set_comment("#");
+        const string sc = "if x 'str' 4.5 #note\n y";
+        DialLexer loaded_lexer;
+        loaded_lexer.load_image(dial_lexer.save_image());
+        CHECK(lexemes_of(loaded_lexer.split(sc)) == lexemes_of(dial_lexer.split(sc)));
+    }
+
+    SUBCASE("regex lexers use the saved DFA tables in place") {
+        DialLexer dial_lexer(LexerType::REGEX);
+        dial_lexer.set_regex_engine(DialRegexEngine::DFA);
+        dial_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+        dial_lexer.add_token({ TokenType::NUMBER, "[0-9]+(\\.[0-9]+)?", DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+        dial_lexer.add_token({ TokenType::IDENTIFIER, "[a-z][a-z0-9]*", DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+        const string sc = "if iffy 12.5 x9 if";
+        vector<string> expected = lexemes_of(dial_lexer.split(sc));
+        const string path = "dial_lexer_test.image";
+        {
+            std::ofstream file(path, std::ios::binary);
+            string image = dial_lexer.save_image();
+            file.write(image.data(), static_cast<std::streamsize>(image.size()));
+        }
+        DialLexer mapped_lexer;
+        mapped_lexer.map_image(path);
+        std::remove(path.c_str());
+        vector<Token> splitted_tokens = mapped_lexer.split(sc);
+        CHECK(lexemes_of(splitted_tokens) == expected);
+        CHECK(splitted_tokens[1].get_type() == TokenType::IDENTIFIER);
+        DialRegexStats stats = mapped_lexer.regex_stats();
+        CHECK(stats.engine == DialRegexEngine::DFA);
+        CHECK(stats.nfa_states == 0);
+        CHECK(stats.dfa_states == dial_lexer.regex_stats().dfa_states);
+
+        DialLexer copied_lexer = mapped_lexer;
+        CHECK(lexemes_of(copied_lexer.split(sc)) == expected);
+    }
+
+    SUBCASE("malformed images are rejected") {
+        DialLexer dial_lexer(LexerType::REGEX);
+        dial_lexer.set_regex_engine(DialRegexEngine::DFA);
+        dial_lexer.add_token({ TokenType::IDENTIFIER, "[a-z]+", DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+        string image = dial_lexer.save_image();
+        DialLexer loaded_lexer;
+        CHECK_THROWS_AS(loaded_lexer.load_image(image.substr(0, image.size() / 2)), DialLexerException);
+        DialImageHeader header;
+        std::memcpy(&header, image.data(), sizeof(header));
+        REQUIRE(header.dfa_size > 0);
+        //a transition to a state the table doesn't hold
+        string corrupted = image;
+        corrupted[header.dfa_offset + header.dfa_size - 1] = static_cast<char>(0xff);
+        CHECK_THROWS_AS(loaded_lexer.load_image(corrupted), DialLexerException);
+        CHECK_THROWS_AS(loaded_lexer.load_image("not an image"), DialLexerException);
+        CHECK_THROWS_AS(loaded_lexer.map_image("missing_dial_lexer.image"), DialLexerException);
+    }
+}
+
+TEST_CASE("Testing Spec Files") {
+    const std::unordered_map<string, TokenType> types = {
+        { "IF", TokenType::IF }, { "ELSE", TokenType::ELSE }, { "WHILE", TokenType::WHILE },
+        { "NUMBER", TokenType::NUMBER }, { "STRING", TokenType::STRING }, { "IDENTIFIER", TokenType::IDENTIFIER }
+    };
+
+    SUBCASE("raw specs match the lexer built in code") {
+        const string spec =
+            "# raw spec\n"
+            "lexer raw\n"
+            "comment \"//\"\n"
+            "keywords on\n"
+            "rule IF none \"if\"\n"
+            "rule ELSE none \"else\"\n"
+            "rule NUMBER number\n"
+            "rule STRING string_start \"\\\"\"\n"
+            "rule STRING string_end \"\\\"\"   # same delimiter\n"
+            "rule IDENTIFIER identifier alpha_lower \"_\"\n";
+        DialLexer spec_lexer = DialLexer::from_spec(spec, types);
+
+        DialLexer dial_lexer;
+        dial_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+        dial_lexer.add_token({ TokenType::ELSE, "else", DIAL_LEXER_VALUE::DIAL_NONE });
+        dial_lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+        dial_lexer.add_token({ TokenType::STRING, "\"", DIAL_LEXER_VALUE::DIAL_STRING_START });
+        dial_lexer.add_token({ TokenType::STRING, "\"", DIAL_LEXER_VALUE::DIAL_STRING_END });
+        dial_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER + "|_", DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+        dial_lexer.set_comment("//");
+        dial_lexer.set_keyword_mode(true);
+
+        const string sc = "if iffy_x \"text\" // note\n else 3.5";
+        vector<Token> expected = dial_lexer.split(sc), splitted_tokens = spec_lexer.split(sc);
+        REQUIRE(splitted_tokens.size() == expected.size());
+        for (size_t i = 0; i < expected.size(); i++) {
+            CHECK(splitted_tokens[i].get_type() == expected[i].get_type());
+            CHECK(splitted_tokens[i].get_lexeme() == expected[i].get_lexeme());
+        }
+        CHECK(splitted_tokens[1].get_lexeme() == "iffy_x");
+    }
+
+    SUBCASE("priorities reorder regex rules") {
+        const string spec =
+            "lexer regex\n"
+            "engine dfa\n"
+            "rule IDENTIFIER identifier \"[a-z]+\"\n"
+            "rule WHILE none \"while\" priority 5\n";
+        DialLexer spec_lexer = DialLexer::from_spec(spec, types);
+        vector<Token> splitted_tokens = spec_lexer.split("while x");
+        REQUIRE(splitted_tokens.size() == 2);
+        CHECK(splitted_tokens[0].get_type() == TokenType::WHILE);
+        CHECK(splitted_tokens[1].get_type() == TokenType::IDENTIFIER);
+        CHECK(spec_lexer.regex_stats().engine == DialRegexEngine::DFA);
+    }
+
+    SUBCASE("spec errors report their lines") {
+        const string spec =
+            "lexer raw\n"
+            "rule FOR none \"for\"\n"
+            "\n"
+            "rule IF none \"if\n"
+            "rule IF nothing \"if\"\n"
+            "colour blue\n";
+        string message;
+        try {
+            DialLexer::from_spec(spec, types);
+        }
+        catch (const DialLexerException& e) {
+            message = e.what();
+        }
+        CHECK(message.find("unknown token type FOR at position 10 at line 2") != string::npos);
+        CHECK(message.find("unterminated string at position 31 at line 4") != string::npos);
+        CHECK(message.find("unknown token value nothing") != string::npos);
+        CHECK(message.find("unknown directive colour at position 69 at line 6") != string::npos);
+        CHECK_THROWS_AS(DialLexer::from_spec("rule IF none \"if\" priority high\n", types), DialLexerException);
+        CHECK_THROWS_AS(DialLexer::from_spec("rule NUMBER none\n", types), DialLexerException);
+    }
+}
+
+TEST_CASE("Testing Lexer Handle Reload") {
+    DialLexer first_lexer;
+    first_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+    first_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER, DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+    DialLexerHandle handle(first_lexer);
+    CHECK(handle.version() == 1);
+    CHECK(handle.split("if x").size() == 2);
+    CHECK_THROWS_AS(handle.split("if 1"), DialLexerException);
+
+    SUBCASE("new splits see the reloaded lexer") {
+        std::shared_ptr<const DialLexer> previous = handle.current();
+        DialLexer second_lexer = first_lexer;
+        second_lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+        handle.reload(second_lexer);
+        CHECK(handle.version() == 2);
+        vector<Token> splitted_tokens = handle.split("if 1");
+        REQUIRE(splitted_tokens.size() == 2);
+        CHECK(splitted_tokens[1].get_type() == TokenType::NUMBER);
+        //a version taken before the reload still splits with its own rules
+        DialLexer previous_lexer = *previous;
+        CHECK_THROWS_AS(previous_lexer.split("if 1"), DialLexerException);
+    }
+
+    SUBCASE("invalid lexers keep the current version") {
+        DialLexer invalid_lexer;
+        invalid_lexer.add_token({ TokenType::STRING, "\"", DIAL_LEXER_VALUE::DIAL_STRING_START });
+        CHECK_THROWS_AS(handle.reload(invalid_lexer), DialLexerException);
+        CHECK(handle.version() == 1);
+        CHECK(handle.split("if x").size() == 2);
+    }
+
+    SUBCASE("readers keep splitting while versions are published") {
+        std::atomic<bool> done{ false };
+        std::atomic<size_t> failures{ 0 };
+        vector<std::thread> readers;
+        for (int i = 0; i < 3; i++) {
+            readers.emplace_back([&]() {
+                while (!done.load()) {
+                    if (handle.split("if x if y").size() != 4) {
+                        failures++;
+                    }
+                }
+            });
+        }
+        for (int i = 0; i < 20; i++) {
+            DialLexer next_lexer = first_lexer;
+            next_lexer.set_keyword_mode(i % 2 == 0);
+            handle.reload(next_lexer);
+        }
+        done = true;
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+        CHECK(failures.load() == 0);
+        CHECK(handle.version() == 21);
+    }
+
+    SUBCASE("a reload on another thread is seen by the version this thread took") {
+        CHECK_THROWS_AS(handle.split("if 1"), DialLexerException);
+        DialLexer second_lexer = first_lexer;
+        second_lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+        std::thread([&]() { handle.reload(second_lexer); }).join();
+        CHECK(handle.version() == 2);
+        CHECK(handle.split("if 1").size() == 2);
+        //a handle made after another is destroyed never sees its versions
+        auto other_handle = std::make_unique<DialLexerHandle>(second_lexer);
+        CHECK(other_handle->split("if 1").size() == 2);
+        other_handle = std::make_unique<DialLexerHandle>(first_lexer);
+        CHECK_THROWS_AS(other_handle->split("if 1"), DialLexerException);
+    }
+}
+
+TEST_CASE("Testing Lexer Registry") {
+    const std::unordered_map<string, TokenType> types = {
+        { "IF", TokenType::IF }, { "ELSE", TokenType::ELSE }, { "NUMBER", TokenType::NUMBER }, { "IDENTIFIER", TokenType::IDENTIFIER }
+    };
+    const string if_spec = "rule IF none \"if\"\nrule IDENTIFIER identifier alpha_lower\n";
+    const string else_spec = "rule ELSE none \"else\"\nrule NUMBER number\n";
+
+    SUBCASE("lexers are compiled once and shared") {
+        DialLexerRegistry registry(types, 1 << 20);
+        std::shared_ptr<const DialLexer> lexer = registry.get(if_spec);
+        CHECK(registry.get(if_spec) == lexer);
+        CHECK(registry.split(if_spec, "if x").size() == 2);
+        CHECK(registry.split(else_spec, "else 4").size() == 2);
+        CHECK_THROWS_AS(registry.split(else_spec, "if"), DialLexerException);
+        DialRegistryStats stats = registry.stats();
+        CHECK(stats.hits == 3);
+        CHECK(stats.misses == 2);
+        CHECK(stats.entries == 2);
+        CHECK(stats.evictions == 0);
+        CHECK(stats.hit_rate() == doctest::Approx(0.6));
+        CHECK(stats.compile_seconds > 0);
+        CHECK(stats.max_compile_seconds <= stats.compile_seconds);
+        CHECK(stats.memory_bytes >= lexer->memory_usage());
+    }
+
+    SUBCASE("least recently used lexers are evicted past the budget") {
+        size_t lexer_bytes = DialLexer::from_spec(if_spec, types).memory_usage();
+        DialLexerRegistry registry(types, lexer_bytes * 2 + lexer_bytes / 2);
+        std::shared_ptr<const DialLexer> evicted = registry.get(if_spec);
+        registry.get(else_spec);
+        registry.get(else_spec + "\n");
+        DialRegistryStats stats = registry.stats();
+        CHECK(stats.evictions == 1);
+        CHECK(stats.entries == 2);
+        CHECK(stats.memory_bytes <= lexer_bytes * 2 + lexer_bytes / 2);
+        //a lexer still held by a caller stays usable after its eviction
+        DialLexer held_lexer = *evicted;
+        CHECK(held_lexer.split("if y").size() == 2);
+        CHECK(registry.get(if_spec) != evicted);
+        CHECK(registry.stats().misses == 4);
+    }
+
+    SUBCASE("invalid specs are not cached") {
+        DialLexerRegistry registry(types, 1 << 20);
+        CHECK_THROWS_AS(registry.get("rule WHILE none \"while\"\n"), DialLexerException);
+        CHECK(registry.stats().entries == 0);
+    }
+
+    SUBCASE("thread copies of expired lexers are dropped first") {
+        vector<std::shared_ptr<const DialLexer>> lexers;
+        for (size_t i = 0; i < DialWorkerCache<DialLexer>::SLOTS; i++) {
+            lexers.push_back(std::make_shared<const DialLexer>(DialLexer::from_spec(if_spec + string(i, '\n'), types)));
+        }
+        size_t recopied = 0;
+        //a new thread starts with empty slots
+        std::thread([&]() {
+            for (const auto& lexer : lexers) {
+                DialWorkerCache<DialLexer>::worker(lexer);
+            }
+            lexers[3].reset();
+            DialWorkerCache<DialLexer>::worker(std::make_shared<const DialLexer>(DialLexer::from_spec(else_spec, types)));
+            for (const auto& lexer : lexers) {
+                size_t before = allocation_count;
+                if (lexer) {
+                    DialWorkerCache<DialLexer>::worker(lexer);
+                }
+                recopied += allocation_count - before;
+            }
+        }).join();
+        CHECK(recopied == 0);
+    }
+}
+
+enum class JsonToken : int {
+    LEFT_BRACE,
+    RIGHT_BRACE,
+    COLON,
+    COMMA,
+    NUMBER,
+    STRING,
+    KEYWORD
+};
+
+template <>
+struct dial::DialTokenTraits<JsonToken> {
+    static constexpr size_t count = 7;
+};
+
+enum class ShellToken : int {
+    WORD,
+    PIPE
+};
+
+TEST_CASE("Testing Lexers Over User Token Types") {
+    BasicDialLexer<JsonToken> json_lexer;
+    json_lexer.add_token({ JsonToken::LEFT_BRACE, "{", DIAL_LEXER_VALUE::DIAL_NONE });
+    json_lexer.add_token({ JsonToken::RIGHT_BRACE, "}", DIAL_LEXER_VALUE::DIAL_NONE });
+    json_lexer.add_token({ JsonToken::COLON, ":", DIAL_LEXER_VALUE::DIAL_NONE });
+    json_lexer.add_token({ JsonToken::COMMA, ",", DIAL_LEXER_VALUE::DIAL_NONE });
+    json_lexer.add_token({ JsonToken::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+    json_lexer.add_token({ JsonToken::STRING, "\"", DIAL_LEXER_VALUE::DIAL_STRING_START });
+    json_lexer.add_token({ JsonToken::STRING, "\"", DIAL_LEXER_VALUE::DIAL_STRING_END });
+    json_lexer.add_token({ JsonToken::KEYWORD, IS_IDENTIFIER_ALPHA_LOWER, DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+
+    BasicDialLexer<ShellToken> shell_lexer(LexerType::REGEX);
+    shell_lexer.add_token({ ShellToken::WORD, "[a-z]+", DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+    shell_lexer.add_token({ ShellToken::PIPE, "\\|", DIAL_LEXER_VALUE::DIAL_NONE });
+
+    SUBCASE("several vocabularies are lexed in one binary") {
+        vector<BasicToken<JsonToken>> json_tokens = json_lexer.split("{\"a\": 1, \"b\": true}");
+        REQUIRE(json_tokens.size() == 9);
+        CHECK(json_tokens[0].get_type() == JsonToken::LEFT_BRACE);
+        CHECK(json_tokens[1].get_type() == JsonToken::STRING);
+        CHECK(json_tokens[3].get_type() == JsonToken::NUMBER);
+        CHECK(json_tokens[7].get_type() == JsonToken::KEYWORD);
+
+        vector<BasicToken<ShellToken>> shell_tokens = shell_lexer.split("ls | wc");
+        REQUIRE(shell_tokens.size() == 3);
+        CHECK(shell_tokens[1].get_type() == ShellToken::PIPE);
+
+        DialLexer dial_lexer;
+        dial_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+        CHECK(dial_lexer.split("if").size() == 1);
+    }
+
+    SUBCASE("filters index dense token types") {
+        BasicDialLexer<JsonToken>::SplitOptions options;
+        options.filter.types = { JsonToken::STRING, JsonToken::KEYWORD };
+        options.filter.values = { DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE };
+        vector<BasicToken<JsonToken>> json_tokens = json_lexer.split("{\"a\": 1, \"b\": true}", options);
+        vector<string> lexemes;
+        for (const auto& token : json_tokens) {
+            lexemes.push_back(token.get_lexeme());
+        }
+        CHECK(lexemes == vector<string>{ "\"a\"", "1", "\"b\"", "true" });
+
+        BasicTokenFilter<ShellToken> filter;
+        filter.types = { ShellToken::PIPE };
+        vector<BasicToken<ShellToken>> shell_tokens = shell_lexer.split("ls | wc | sort", filter);
+        REQUIRE(shell_tokens.size() == 2);
+        CHECK(shell_tokens[0].get_lexeme() == "|");
+    }
+
+    SUBCASE("handles and registries take the token type of their lexer") {
+        BasicDialLexerHandle<ShellToken> handle(shell_lexer);
+        CHECK(handle.split("a | b").size() == 3);
+        BasicDialLexerRegistry<JsonToken> registry({ { "COMMA", JsonToken::COMMA }, { "NUMBER", JsonToken::NUMBER } }, 1 << 20);
+        vector<BasicToken<JsonToken>> json_tokens = registry.split("rule COMMA none \",\"\nrule NUMBER number\n", "1,2");
+        REQUIRE(json_tokens.size() == 3);
+        CHECK(json_tokens[1].get_type() == JsonToken::COMMA);
+    }
+}
+
+struct MinimalPolicy : DialDefaultPolicy {
+    static constexpr DialPositionTracking positions = DialPositionTracking::NONE;
+    static constexpr bool comments = false;
+    static constexpr DialErrorStrategy errors = DialErrorStrategy::SKIP;
+    using char_type = unsigned char;
+};
+
+struct ColumnPolicy : DialDefaultPolicy {
+    static constexpr DialPositionTracking positions = DialPositionTracking::LINE_COLUMN;
+};
+
+struct NoCommentPolicy : DialDefaultPolicy {
+    static constexpr bool comments = false;
+};
+
+TEST_CASE("Testing Lexer Policies") {
+    auto add_rules = [](auto& lexer) {
+        lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+        lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+        lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER, DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+    };
+
+    SUBCASE("minimal policy skips errors and positions") {
+        BasicDialLexer<TokenType, MinimalPolicy> lexer;
+        add_rules(lexer);
+        const unsigned char raw[] = "if x\n@@ 12\ny";
+        vector<Token> tokens = lexer.split(std::basic_string_view<unsigned char>(raw, sizeof(raw) - 1));
+        vector<string> lexemes;
+        for (const Token& token : tokens) {
+            lexemes.push_back(token.get_lexeme());
+            CHECK(token.get_line() == -1);
+            CHECK(token.get_column() == -1);
+        }
+        CHECK(lexemes == vector<string>{ "if", "x", "y" });
+
+        DialLexer default_lexer;
+        add_rules(default_lexer);
+        CHECK_THROWS_AS(default_lexer.split("if x\n@@ 12\ny"), DialLexerException);
+    }
+
+    SUBCASE("columns are tracked per line") {
+        BasicDialLexer<TokenType, ColumnPolicy> lexer;
+        add_rules(lexer);
+        vector<Token> tokens = lexer.split("if x\n  12 y\nz");
+        REQUIRE(tokens.size() == 5);
+        CHECK(tokens[1].get_column() == 4);
+        CHECK(tokens[2].get_line() == 2);
+        CHECK(tokens[2].get_column() == 3);
+        CHECK(tokens[3].get_column() == 6);
+        CHECK(tokens[4].get_line() == 3);
+        CHECK(tokens[4].get_column() == 1);
+
+        BasicDialLexer<TokenType, ColumnPolicy> regex_lexer(LexerType::REGEX);
+        regex_lexer.add_token({ TokenType::IDENTIFIER, "[a-z]+", DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+        tokens = regex_lexer.split("ab\n cd");
+        REQUIRE(tokens.size() == 2);
+        CHECK(tokens[1].get_line() == 2);
+        CHECK(tokens[1].get_column() == 2);
+    }
+
+    SUBCASE("specs and programs with comments are rejected without comments") {
+        using NoCommentLexer = BasicDialLexer<TokenType, NoCommentPolicy>;
+        const std::unordered_map<string, TokenType> types = { { "IF", TokenType::IF }, { "IDENTIFIER", TokenType::IDENTIFIER } };
+        const string spec = "rule IF none \"if\"\nrule IDENTIFIER identifier alpha_lower\n";
+        CHECK(NoCommentLexer::from_spec(spec, types).split("if x").size() == 2);
+        try {
+            NoCommentLexer::from_spec(spec + "comment \"#\"\n", types);
+            FAIL("a comment directive must be rejected");
+        }
+        catch (const DialLexerException& ex) {
+            CHECK(string(ex.what()).find("comments are disabled by the lexer policy") != string::npos);
+            CHECK(string(ex.what()).find("at line 3") != string::npos);
+        }
+
+        BasicDialLexerRegistry<TokenType, NoCommentPolicy> registry(types, 1 << 20);
+        CHECK(registry.split(spec, "if y").size() == 2);
+        CHECK_THROWS_AS(registry.get(spec + "comment \"#\"\n"), DialLexerException);
+
+        DialLexer commented_lexer = DialLexer::from_spec(spec + "comment \"#\"\n", types);
+        NoCommentLexer image_lexer;
+        CHECK_THROWS_AS(image_lexer.load_image(commented_lexer.save_image()), DialLexerException);
+        image_lexer.load_image(DialLexer::from_spec(spec, types).save_image());
+        CHECK(image_lexer.split("if z").size() == 2);
+    }
+}
+
+TEST_CASE("Testing Token Offsets And Line Index") {
+    DialLexer dial_lexer;
+    dial_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::STRING, "\"", DIAL_LEXER_VALUE::DIAL_STRING_START });
+    dial_lexer.add_token({ TokenType::STRING, "\"", DIAL_LEXER_VALUE::DIAL_STRING_END });
+    dial_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER, DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+
+    string source = "if a\n\"multi\nline\" b\n\nc";
+
+    SUBCASE("tokens keep their offset and starting line") {
+        vector<Token> tokens = dial_lexer.split(source);
+        REQUIRE(tokens.size() == 5);
+        CHECK(tokens[1].get_offset() == 3);
+        CHECK(tokens[2].get_offset() == 5);
+        CHECK(tokens[2].get_line() == 2);
+        CHECK(tokens[3].get_line() == 3);
+        CHECK(tokens[4].get_offset() == source.size() - 1);
+        CHECK(tokens[4].get_line() == 5);
+    }
+
+    SUBCASE("the line index locates offsets on demand") {
+        BasicDialLexer<TokenType, MinimalPolicy> lexer;
+        lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER, DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+        vector<Token> tokens = lexer.split(std::string_view("ab\n cd\n\n  ef"));
+        REQUIRE(tokens.size() == 3);
+
+        DialLineIndex index("ab\n cd\n\n  ef");
+        CHECK(index.line_count() == 4);
+        CHECK(index.line_of(tokens[0].get_offset()) == 1);
+        CHECK(index.line_of(tokens[1].get_offset()) == 2);
+        CHECK(index.column_of(tokens[1].get_offset()) == 2);
+        CHECK(index.line_of(tokens[2].get_offset()) == 4);
+        CHECK(index.column_of(tokens[2].get_offset()) == 3);
+        CHECK(index.line_of(2) == 1);
+        CHECK(index.column_of(2) == 3);
+    }
+}
+
+#if defined(DIAL_LEXER_MMAP)
+#include <filesystem>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//creates a file of @size bytes ending with @tail in the temporary directory, only the tail is stored on disk
+//returns an empty path when the file can't be created or isn't stored sparsely
+static string create_sparse_file(size_t size, const string& tail) {
+    std::error_code error;
+    std::filesystem::path directory = std::filesystem::temp_directory_path(error);
+    if (error) {
+        return "";
+    }
+    string path = (directory / "dial_lexer_sparse_XXXXXX").string();
+    int descriptor = ::mkstemp(&path[0]);
+    if (descriptor < 0) {
+        return "";
+    }
+    struct stat status;
+    bool created = ::ftruncate(descriptor, static_cast<off_t>(size)) == 0 &&
+        ::pwrite(descriptor, tail.data(), tail.size(), static_cast<off_t>(size - tail.size())) == static_cast<ssize_t>(tail.size()) &&
+        ::fstat(descriptor, &status) == 0 && static_cast<size_t>(status.st_blocks) * 512 < (size_t(1) << 24);
+    ::close(descriptor);
+    if (!created) {
+        std::remove(path.c_str());
+        return "";
+    }
+    return path;
+}
+
+static const size_t SPARSE_TAIL_START = (size_t(1) << 32) + 7;
+
+static bool sparse_files_unsupported() {
+    string path = create_sparse_file(SPARSE_TAIL_START + 1, "x");
+    if (path.empty()) {
+        return true;
+    }
+    std::remove(path.c_str());
+    return false;
+}
+
+TEST_CASE("Testing Positions Past 4 GB" * doctest::skip(sparse_files_unsupported())) {
+    //a sparse file only stores its tail, the lexer starts a slice right before it
+    const string tail = "if x\n12 y";
+    const size_t tail_start = SPARSE_TAIL_START;
+    const string path = create_sparse_file(tail_start + tail.size(), tail);
+    REQUIRE_FALSE(path.empty());
+    std::shared_ptr<const DialMappedFile> input = DialMappedFile::open(path);
+    std::remove(path.c_str());
+    std::string_view raw(input->data(), input->size());
+    REQUIRE(raw.size() == tail_start + tail.size());
+
+    SUBCASE("raw lexers") {
+        DialLexer dial_lexer;
+        dial_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+        dial_lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+        dial_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER, DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+        SplitState state;
+        state.position = tail_start;
+        state.line = int64_t(3) << 31;
+        vector<Token> tokens;
+        CHECK(dial_lexer.split_slice(raw, state, tail.size(), SplitOptions(), tokens));
+        CHECK_FALSE(state.has_error);
+        REQUIRE(tokens.size() == 4);
+        CHECK(tokens[0].get_offset() == tail_start);
+        CHECK(tokens[2].get_lexeme() == "12");
+        CHECK(tokens[2].get_offset() == tail_start + 5);
+        CHECK(tokens[2].get_line() == (int64_t(3) << 31) + 1);
+        CHECK(state.position == raw.size());
+        CHECK(state.line == (int64_t(3) << 31) + 1);
+    }
+
+    SUBCASE("regex lexers") {
+        DialLexer dial_lexer(LexerType::REGEX);
+        dial_lexer.set_regex_engine(DialRegexEngine::DFA);
+        dial_lexer.add_token({ TokenType::NUMBER, "[0-9]+", DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+        dial_lexer.add_token({ TokenType::IDENTIFIER, "[a-z]+", DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+        SplitState state;
+        state.position = tail_start;
+        vector<Token> tokens;
+        CHECK(dial_lexer.split_slice(raw, state, tail.size(), SplitOptions(), tokens));
+        REQUIRE(tokens.size() == 4);
+        CHECK(tokens[3].get_lexeme() == "y");
+        CHECK(tokens[3].get_offset() == raw.size() - 1);
+        CHECK(tokens[3].get_line() == 2);
+    }
+}
+#endif
+
+#if defined(DIAL_LEXER_COROUTINES)
+//starts right away and runs until its first suspension, the driving loop resumes it from there
+struct AsyncTestTask {
+    struct promise_type {
+        AsyncTestTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+//hands out @chunk bytes per read, each read completes on the next turn of @pending
+struct AsyncTestReader {
+    std::string_view content;
+    size_t chunk;
+    std::deque<std::coroutine_handle<>>* pending;
+
+    struct Read {
+        AsyncTestReader* reader;
+        char* buffer;
+        size_t size;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { reader->pending->push_back(handle); }
+        size_t await_resume()
+        {
+            size_t count = std::min({ size, reader->chunk, reader->content.size() });
+            std::memcpy(buffer, reader->content.data(), count);
+            reader->content.remove_prefix(count);
+            return count;
+        }
+    };
+
+    Read read(char* buffer, size_t size) { return Read{ this, buffer, size }; }
+};
+
+AsyncTestTask collect_async_tokens(DialTokenStream stream, vector<Token>& tokens, string& error, bool& done)
+{
+    try {
+        //the awaited result is kept out of the loop condition, GCC 12 miscompiles a co_await there
+        for (bool more = co_await stream.next(); more; more = co_await stream.next()) {
+            tokens.insert(tokens.end(), stream.tokens().begin(), stream.tokens().end());
+        }
+    }
+    catch (const DialLexerException& ex) {
+        error = ex.what();
+    }
+    done = true;
+}
+
+//records how much of @reader was still unread when each batch of tokens was handed out
+AsyncTestTask collect_async_batches(DialTokenStream stream, const AsyncTestReader& reader, vector<Token>& tokens, vector<size_t>& unread, bool& done)
+{
+    for (bool more = co_await stream.next(); more; more = co_await stream.next()) {
+        unread.push_back(reader.content.size());
+        tokens.insert(tokens.end(), stream.tokens().begin(), stream.tokens().end());
+    }
+    done = true;
+}
+
+TEST_CASE("Testing Async Token Streams") {
+    DialLexer dial_lexer;
+    dial_lexer.add_token({ TokenType::IF, "if", DIAL_LEXER_VALUE::DIAL_NONE });
+    dial_lexer.add_token({ TokenType::NUMBER, IS_NUMBER, DIAL_LEXER_VALUE::DIAL_NUMBER_DOUBLE });
+    dial_lexer.add_token({ TokenType::STRING, "\"", DIAL_LEXER_VALUE::DIAL_STRING_START });
+    dial_lexer.add_token({ TokenType::STRING, "\"", DIAL_LEXER_VALUE::DIAL_STRING_END });
+    dial_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER, DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+    dial_lexer.set_comment("/*", "*/");
+
+    const string first = "if alpha 12.5\n\"a string\nover lines\" beta\n/* a comment\nover lines */ if\ngamma 7";
+    const string second = "delta\n\n  if 3 \"x\"\nepsilon";
+    std::deque<std::coroutine_handle<>> pending;
+
+    SUBCASE("many contents are lexed in flight on one thread") {
+        AsyncTestReader first_reader{ first, 3, &pending };
+        AsyncTestReader second_reader{ second, 5, &pending };
+        vector<Token> first_tokens, second_tokens;
+        string first_error, second_error;
+        bool first_done = false, second_done = false;
+        collect_async_tokens(dial_lexer.split_async(first_reader, TokenFilter(), 4), first_tokens, first_error, first_done);
+        collect_async_tokens(dial_lexer.split_async(second_reader, TokenFilter(), 4), second_tokens, second_error, second_done);
+        while (!pending.empty()) {
+            std::coroutine_handle<> handle = pending.front();
+            pending.pop_front();
+            handle.resume();
+        }
+        REQUIRE(first_done);
+        REQUIRE(second_done);
+        CHECK(first_error.empty());
+        CHECK(second_error.empty());
+
+        vector<Token> expected = dial_lexer.split(first);
+        CHECK(first_tokens == expected);
+        REQUIRE(first_tokens.size() == expected.size());
+        for (size_t i = 0; i < expected.size(); i++) {
+            CHECK(first_tokens[i].get_offset() == expected[i].get_offset());
+        }
+        CHECK(second_tokens == dial_lexer.split(second));
+    }
+
+    SUBCASE("content without newlines is handed out while it is read") {
+        string line;
+        for (int i = 0; i < 50; i++) {
+            line.append("if alpha 12.5 \"a long string of words\" /* a comment */ beta ");
+        }
+        AsyncTestReader reader{ line, 7, &pending };
+        vector<Token> tokens;
+        bool done = false;
+        vector<size_t> unread;
+        collect_async_batches(dial_lexer.split_async(reader, TokenFilter(), 16), reader, tokens, unread, done);
+        while (!pending.empty()) {
+            std::coroutine_handle<> handle = pending.front();
+            pending.pop_front();
+            handle.resume();
+        }
+        REQUIRE(done);
+        REQUIRE(unread.size() > 10);
+        CHECK(unread.front() > line.size() / 2);
+        vector<Token> expected = dial_lexer.split(line);
+        CHECK(tokens == expected);
+
+        BasicDialLexer<TokenType, ColumnPolicy> column_lexer;
+        column_lexer.add_token({ TokenType::IDENTIFIER, IS_IDENTIFIER_ALPHA_LOWER, DIAL_LEXER_VALUE::DIAL_IDENTIFIER });
+        const string words = "ab cd\nef gh ij kl mn op qr st uv wx yz";
+        AsyncTestReader column_reader{ words, 4, &pending };
+        vector<Token> column_tokens;
+        string error;
+        done = false;
+        collect_async_tokens(column_lexer.split_async(column_reader, TokenFilter(), 4), column_tokens, error, done);
+        while (!pending.empty()) {
+            std::coroutine_handle<> handle = pending.front();
+            pending.pop_front();
+            handle.resume();
+        }
+        REQUIRE(done);
+        CHECK(error.empty());
+        vector<Token> column_expected = column_lexer.split(words);
+        REQUIRE(column_tokens.size() == column_expected.size());
+        for (size_t i = 0; i < column_expected.size(); i++) {
+            CHECK(column_tokens[i] == column_expected[i]);
+            CHECK(column_tokens[i].get_column() == column_expected[i].get_column());
+            CHECK(column_tokens[i].get_offset() == column_expected[i].get_offset());
+        }
+    }
+
+    SUBCASE("filters and errors reach the consumer") {
+        AsyncTestReader reader{ second, 2, &pending };
+        vector<Token> tokens;
+        string error;
+        bool done = false;
+        collect_async_tokens(dial_lexer.split_async(reader, TokenFilter{ { TokenType::IDENTIFIER }, {} }), tokens, error, done);
+        while (!pending.empty()) {
+            std::coroutine_handle<> handle = pending.front();
+            pending.pop_front();
+            handle.resume();
+        }
+        REQUIRE(done);
+        REQUIRE(tokens.size() == 2);
+        CHECK(tokens[0].get_lexeme() == "delta");
+        CHECK(tokens[1].get_lexeme() == "epsilon");
+        CHECK(tokens[1].get_line() == 4);
+
+        AsyncTestReader failing_reader{ "if x\n@\ny", 1, &pending };
+        done = false;
+        collect_async_tokens(dial_lexer.split_async(failing_reader), tokens, error, done);
+        while (!pending.empty()) {
+            std::coroutine_handle<> handle = pending.front();
+            pending.pop_front();
+            handle.resume();
+        }
+        REQUIRE(done);
+        CHECK(error.find("at line 2") != string::npos);
+    }
+}
+#endif